@@ -0,0 +1,172 @@
+// ebnftobison_api.bench.cpp
+
+/*
+MIT License
+
+Copyright (c) 2024 Zartaj Majeed
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <cstdio>
+#include <cstdlib>
+#include <chrono>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <algorithm>
+
+#include <fcntl.h>
+#include <getopt.h>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "api/ebnftobison_api.h"
+#include "lexer/ebnftobison_mapped_file.h"
+
+using namespace std;
+using namespace ebnftobison;
+
+extern char** environ;
+
+namespace {
+
+// latency benchmark of one conversion, in process through the library and as a separate ebnftobison process
+// the difference is what a build tool or editor saves by embedding the converter instead of running the executable
+
+struct Result {
+  vector<double> secs;
+  bool failed = false;
+};
+
+template<typename F>
+Result run(int iterations, F convertOnce) {
+  Result result;
+  for(int i = 0; i < iterations; ++i) {
+    auto startTime = chrono::steady_clock::now();
+    result.failed |= !convertOnce();
+    auto endTime = chrono::steady_clock::now();
+    result.secs.push_back(chrono::duration<double>(endTime - startTime).count());
+  }
+  return result;
+}
+
+// process output goes to /dev/null so only startup, conversion and writing are timed
+bool spawnConverter(const string& executable, const string& inputFile) {
+  posix_spawn_file_actions_t actions;
+  posix_spawn_file_actions_init(&actions);
+  posix_spawn_file_actions_addopen(&actions, STDOUT_FILENO, "/dev/null", O_WRONLY, 0);
+  const char* args[] = {executable.c_str(), inputFile.c_str(), nullptr};
+  pid_t pid;
+  auto error = posix_spawn(&pid, executable.c_str(), &actions, nullptr, const_cast<char**>(args), environ);
+  posix_spawn_file_actions_destroy(&actions);
+  if(error != 0) {
+    return false;
+  }
+  int status;
+  waitpid(pid, &status, 0);
+  return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+void report(const char* name, Result&& result) {
+  auto& secs = result.secs;
+  ranges::sort(secs);
+  double total = 0;
+  for(auto s: secs) {
+    total += s;
+  }
+  printf("%-8s mean %.6f secs, median %.6f secs, min %.6f secs, max %.6f secs%s\n", name, total / secs.size(), secs[secs.size() / 2], secs.front(), secs.back(), result.failed? " (conversion failed)": "");
+}
+
+void usage() {
+  puts("usage: ebnftobison_api.bench [-i iterations] [-x executable] [grammar_file]");
+  puts("convert grammar_file repeatedly and report latency per conversion");
+  puts("reused: one Converter for every conversion, fresh: a new Converter each time, process: a new ebnftobison process each time");
+  puts("-i, --iterations: number of conversions of each kind, default 20");
+  puts("-x, --executable: ebnftobison executable for process conversions, defaults to the one built with this benchmark");
+  puts("grammar_file: defaults to docs/gqlgrammar.quotedliterals.txt");
+  puts("-h, --help: print this help");
+}
+
+}
+
+int main(int argc, char* argv[]) {
+
+  int iterations = 20;
+  string executable = EBNFTOBISON_EXECUTABLE;
+  string inputFile = EBNFTOBISON_DOCS_DIR "/gqlgrammar.quotedliterals.txt";
+
+  option longOptions[] = {
+    {"iterations", required_argument, nullptr, 'i'},
+    {"executable", required_argument, nullptr, 'x'},
+    {"help", no_argument, nullptr, 'h'},
+    {}
+  };
+
+  for(int opt; (opt = getopt_long(argc, argv, "i:x:h", longOptions, nullptr)) != -1;) {
+    switch(opt) {
+    case 'i':
+      iterations = atoi(optarg);
+      break;
+    case 'x':
+      executable = optarg;
+      break;
+    case 'h':
+      usage();
+      exit(0);
+    default:
+      usage();
+      exit(1);
+    }
+  }
+
+  if(optind < argc) {
+    inputFile = argv[optind];
+  }
+
+  if(iterations < 1) {
+    fprintf(stderr, "iterations must be at least 1\n");
+    exit(1);
+  }
+
+  MappedFile mappedFile;
+  if(!mappedFile.open(inputFile)) {
+    fprintf(stderr, "could not map %s\n", inputFile.c_str());
+    exit(1);
+  }
+  auto contents = mappedFile.contents();
+
+  printf("%s: %zu bytes, %d iterations\n", inputFile.c_str(), contents.size(), iterations);
+
+  Converter converter;
+  ConvertedGrammar converted;
+  report("reused", run(iterations, [&] {
+    converter.convert(contents, {}, converted);
+    return static_cast<bool>(converted);
+  }));
+
+  report("fresh", run(iterations, [&] {
+    return static_cast<bool>(convert(contents));
+  }));
+
+  report("process", run(iterations, [&] {
+    return spawnConverter(executable, inputFile);
+  }));
+}
@@ -0,0 +1,292 @@
+// ebnftobison_api.cpp
+
+/*
+MIT License
+
+Copyright (c) 2024 Zartaj Majeed
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <iterator>
+#include <optional>
+#include <utility>
+
+#include "api/ebnftobison_api.h"
+#include "api/ebnftobison_printer.h"
+#include "lexer/ebnftobison_lexer.h"
+#include "lexer/ebnftobison_simd_lexer.h"
+#include "lexer/ebnftobison_pipelined_lexer.h"
+#include "parser/ebnftobison_sharded.h"
+#include "parser/ebnftobison_rule_cache.h"
+#include "ebnftobison.bison.h"
+
+namespace ebnftobison {
+
+// everything a conversion needs, made once per Converter
+// the parser takes its tokens through lex so the same parser object works with either lexer and with the pipeline
+struct Converter::State {
+
+  explicit State(bool keepSymbols): keepSymbols(keepSymbols), parser([this](location& loc) { return lex(loc); }, bisonParam, loc) {}
+
+// clears what was left from the last conversion and sets up for the next one
+// returns false with a diagnostic in converted when options can't be used together
+  bool start(const ConvertOptions& options, ConvertedGrammar& converted);
+
+  void finish(int ev, ConvertedGrammar& converted);
+
+  EbnfToBison::symbol_type lex(location& loc);
+
+  EbnfToBison::symbol_type lexInput(location& loc) {
+    return options.useSimdLexer? simdLexer.yylex(loc): lexer.yylex(loc);
+  }
+
+  void print(string& out, GrammarPrinter::Write write);
+
+  bool keepSymbols;
+// options of the last conversion
+  ConvertOptions options;
+// location points to this name for the whole parse
+  string inputName;
+  location loc;
+  Lexer lexer;
+  SimdLexer simdLexer;
+  BisonParam bisonParam;
+// only there during a pipelined parse
+  optional<PipelinedLexer> pipelinedLexer;
+  EbnfToBison parser;
+// stream read into memory for a sharded or cached conversion
+  string streamInput;
+// made for the first cached conversion and kept while its directory and keepRules stay the same
+  optional<RuleCache> ruleCache;
+// text printed by print before it's handed to write
+  string text;
+// rules from a successful parse are there to print
+  bool parsed = false;
+
+};
+
+bool Converter::State::start(const ConvertOptions& newOptions, ConvertedGrammar& converted) {
+  converted.status = 0;
+  converted.text.clear();
+  converted.diagnostics.clear();
+  converted.stats = {};
+  parsed = false;
+
+  auto invalid = [&converted](const char* diagnostic) {
+    converted.status = 1;
+    converted.diagnostics.push_back(diagnostic);
+    return false;
+  };
+  if(newOptions.stream && (newOptions.factorThreshold > 0 || newOptions.productionBudget > 0)) {
+    return invalid("stream can't be used with factorThreshold or productionBudget");
+  }
+  if(newOptions.stream && newOptions.numJobs > 1) {
+    return invalid("stream can't be used with numJobs");
+  }
+  if(newOptions.pipeline && newOptions.numJobs > 1) {
+    return invalid("pipeline can't be used with numJobs");
+  }
+  if((!newOptions.ruleCacheDir.empty() || newOptions.keepRules) && (newOptions.stream || newOptions.pipeline)) {
+    return invalid("ruleCacheDir and keepRules can't be used with stream or pipeline");
+  }
+
+  options = newOptions;
+  inputName = options.inputName;
+  loc = location(&inputName);
+
+  bisonParam.clear(keepSymbols && bisonParam.symbols.size() < maxKeptSymbols);
+// pool is kept from one conversion to the next unless a different number of threads is asked for
+  if(bisonParam.taskPool && bisonParam.taskPool->numThreads() != max(options.expandThreads, size_t{1})) {
+    bisonParam.taskPool.reset();
+  }
+  bisonParam.options = {
+    .factorThreshold = options.factorThreshold,
+    .productionBudget = options.productionBudget,
+    .refuseOverBudget = options.refuseOverBudget,
+    .keepTrees = options.stream,
+    .expandThreads = options.expandThreads,
+  };
+
+  lexer.set_debug(options.debug);
+  simdLexer.set_debug(options.debug);
+  parser.set_debug_level(options.debug);
+
+  if(options.pipeline) {
+    pipelinedLexer.emplace([this](location& loc) { return lexInput(loc); });
+  }
+  return true;
+}
+
+void Converter::State::finish(int ev, ConvertedGrammar& converted) {
+  auto& stats = converted.stats;
+  if(pipelinedLexer) {
+    pipelinedLexer->stop();
+    stats.lexerStallTime = pipelinedLexer->stats().lexerStallTime;
+    stats.parserStallTime = pipelinedLexer->stats().parserStallTime;
+    pipelinedLexer.reset();
+  }
+
+  converted.status = ev;
+  converted.diagnostics.assign(bisonParam.diagnostics.begin(), bisonParam.diagnostics.end());
+  parsed = ev == 0;
+
+  const auto& parseStats = bisonParam.stats;
+  const auto& arena = bisonParam.arena;
+  stats.parseTime = parseStats.parseTimeTakenSec;
+  stats.numRulesParsed = parseStats.numRulesParsed;
+  stats.numRulesGenerated = parseStats.numRulesGenerated;
+  stats.numProductionsGenerated = parseStats.numProductionsGenerated;
+  stats.numOptionalsFactored = parseStats.numOptionalsFactored;
+  stats.numGroupsFactored = parseStats.numGroupsFactored;
+  stats.numChoiceGroups = parseStats.numChoiceGroups;
+  stats.numRulesOverBudget = parseStats.numRulesOverBudget;
+  stats.numSequenceNodes = bisonParam.sequences.size();
+  stats.sequenceBytes = bisonParam.sequences.bytesUsed();
+  stats.arenaAllocations = arena.numAllocations();
+  stats.arenaBytes = arena.bytesAllocated();
+  stats.arenaHeapChunks = arena.numChunks();
+  stats.arenaHeapBytes = arena.chunkBytes();
+  stats.numExpandTasks = parseStats.numExpandTasks;
+  stats.numExpandTasksStolen = parseStats.numExpandTasksStolen;
+  stats.expandTaskTime = parseStats.expandTaskTime;
+  stats.maxExpandTaskTime = parseStats.maxExpandTaskTime;
+  stats.numRuleCacheHits = parseStats.numRuleCacheHits;
+  stats.numRuleCacheMisses = parseStats.numRuleCacheMisses;
+}
+
+EbnfToBison::symbol_type Converter::State::lex(location& loc) {
+  if(pipelinedLexer) {
+    return pipelinedLexer->yylex(loc);
+  }
+  return lexInput(loc);
+}
+
+void Converter::State::print(string& out, GrammarPrinter::Write write) {
+  if(!parsed) {
+    return;
+  }
+  GrammarPrinter printer(bisonParam, options.predictions, out, std::move(write));
+  if(options.stream) {
+    printer.printRuleTrees();
+  } else {
+    printer.printRules();
+  }
+  printer.flush();
+}
+
+Converter::Converter(bool keepSymbols): state(make_unique<State>(keepSymbols)) {
+}
+
+Converter::~Converter() = default;
+
+ConvertedGrammar Converter::convert(string_view input, const ConvertOptions& options) {
+  ConvertedGrammar converted;
+  convert(input, options, converted);
+  return converted;
+}
+
+void Converter::convert(string_view input, const ConvertOptions& options, ConvertedGrammar& converted) {
+  parse(input, options, converted);
+  state->print(converted.text, {});
+}
+
+void Converter::convert(istream& input, const ConvertOptions& options, ConvertedGrammar& converted) {
+  parse(input, options, converted);
+  state->print(converted.text, {});
+}
+
+void Converter::parse(string_view input, const ConvertOptions& options, ConvertedGrammar& converted) {
+  auto& s = *state;
+  if(!s.start(options, converted)) {
+    return;
+  }
+  if(!options.ruleCacheDir.empty() || options.keepRules) {
+    if(!s.ruleCache || s.ruleCache->directory() != options.ruleCacheDir || s.ruleCache->keepsRules() != options.keepRules) {
+      s.ruleCache.emplace(options.ruleCacheDir, options.keepRules);
+    }
+    s.finish(convertCached(input, &s.inputName, s.bisonParam, *s.ruleCache, options.numJobs, options.useSimdLexer), converted);
+    return;
+  }
+  if(options.numJobs > 1) {
+    s.finish(convertSharded(input, &s.inputName, s.bisonParam, options.numJobs, options.useSimdLexer), converted);
+    return;
+  }
+  if(options.useSimdLexer) {
+    s.simdLexer.switch_buffer(input);
+  } else {
+    s.lexer.switch_buffer(input);
+  }
+  s.finish(s.parser(), converted);
+}
+
+// sharded and cached conversions need the whole input in memory
+void Converter::parse(istream& input, const ConvertOptions& options, ConvertedGrammar& converted) {
+  auto& s = *state;
+  if(options.numJobs > 1 || !options.ruleCacheDir.empty() || options.keepRules) {
+    s.streamInput.assign(istreambuf_iterator<char>(input), {});
+    parse(s.streamInput, options, converted);
+    return;
+  }
+  if(!s.start(options, converted)) {
+    return;
+  }
+  if(options.useSimdLexer) {
+    s.simdLexer.switch_streams(&input);
+  } else {
+    s.lexer.switch_streams(&input);
+  }
+  s.finish(s.parser(), converted);
+}
+
+void Converter::print(const Write& write) {
+  state->text.clear();
+  state->print(state->text, write);
+}
+
+void Converter::print(Emitter& emitter, size_t numThreads) {
+  auto& s = *state;
+  if(!s.parsed) {
+    return;
+  }
+  if(s.options.stream) {
+    string out;
+    GrammarPrinter printer(s.bisonParam, s.options.predictions, out, emitter);
+    printer.printRuleTrees();
+    printer.flush();
+    return;
+  }
+  printRulesParallel(s.bisonParam, s.options.predictions, emitter, numThreads);
+}
+
+bool Converter::printSnapshot(string& out) {
+  if(!state->parsed || state->options.stream) {
+    out.clear();
+    return false;
+  }
+  ebnftobison::printSnapshot(state->bisonParam, out);
+  return true;
+}
+
+ConvertedGrammar convert(string_view input, const ConvertOptions& options) {
+  Converter converter;
+  return converter.convert(input, options);
+}
+
+}
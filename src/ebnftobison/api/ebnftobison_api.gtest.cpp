@@ -0,0 +1,665 @@
+// ebnftobison_api.gtest.cpp
+
+/*
+MIT License
+
+Copyright (c) 2024 Zartaj Majeed
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <mutex>
+#include <condition_variable>
+#include <set>
+#include <sstream>
+#include <thread>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include "api/ebnftobison_api.h"
+#include "api/ebnftobison_c_api.h"
+#include "api/ebnftobison_batch.h"
+#include "api/ebnftobison_server.h"
+#include "api/ebnftobison_watch.h"
+#include "api/ebnftobison_snapshot.h"
+#include "api/ebnftobison_emitter.h"
+
+using namespace std;
+
+using namespace ::testing;
+
+namespace ebnftobison::testing {
+
+namespace {
+
+string readFile(const string& filename) {
+  ifstream s(filename);
+  return {istreambuf_iterator<char>(s), {}};
+}
+
+}
+
+TEST(Converter, test_0) {
+
+  auto converted = convert("<true literal> ::= TRUE [ LITERAL ]");
+  ASSERT_TRUE(converted);
+  EXPECT_THAT(converted.diagnostics, IsEmpty());
+  EXPECT_EQ(converted.text, "# 2 productions\ntrue_literal:\n  TRUE\n|  TRUE  LITERAL\n\n");
+  EXPECT_EQ(converted.stats.numRulesParsed, 1);
+  EXPECT_EQ(converted.stats.numProductionsGenerated, 2);
+}
+
+// a reused converter gives the same text as a fresh one whatever it converted before, with every lexer and way of reading input
+TEST(Converter, test_1) {
+
+  auto grammar = readFile(EBNFTOBISON_DOCS_DIR "/gqlgrammar.quotedliterals.txt");
+  auto expected = convert(grammar);
+  ASSERT_TRUE(expected);
+  ASSERT_FALSE(expected.text.empty());
+
+  Converter converter;
+  ConvertedGrammar converted;
+  for(auto useSimdLexer: {false, true}) {
+    converter.convert(grammar, {.useSimdLexer = useSimdLexer}, converted);
+    ASSERT_TRUE(converted);
+    EXPECT_EQ(converted.text, expected.text);
+
+    converter.convert("<a> ::= b", {.useSimdLexer = useSimdLexer}, converted);
+    ASSERT_TRUE(converted);
+    EXPECT_EQ(converted.text, "# 1 productions\na:\n  b\n\n");
+
+    stringstream s(grammar);
+    converter.convert(s, {.useSimdLexer = useSimdLexer}, converted);
+    ASSERT_TRUE(converted);
+    EXPECT_EQ(converted.text, expected.text);
+
+    converter.convert(grammar, {.useSimdLexer = useSimdLexer, .pipeline = true}, converted);
+    ASSERT_TRUE(converted);
+    EXPECT_EQ(converted.text, expected.text);
+
+    converter.convert(grammar, {.useSimdLexer = useSimdLexer, .numJobs = 4}, converted);
+    ASSERT_TRUE(converted);
+    EXPECT_EQ(converted.text, expected.text);
+
+    converter.convert(grammar, {.useSimdLexer = useSimdLexer, .expandThreads = 2}, converted);
+    ASSERT_TRUE(converted);
+    EXPECT_EQ(converted.text, expected.text);
+  }
+
+// printing in pieces gives the same text
+  converter.parse(grammar, {}, converted);
+  ASSERT_TRUE(converted);
+  EXPECT_THAT(converted.text, IsEmpty());
+  string printed;
+  size_t numPieces = 0;
+  converter.print([&](string_view text) {
+    printed += text;
+    ++numPieces;
+  });
+  EXPECT_EQ(printed, expected.text);
+  EXPECT_GT(numPieces, 1);
+}
+
+// failed conversions leave nothing behind for the next one
+TEST(Converter, test_2) {
+
+  Converter converter;
+  ConvertedGrammar converted;
+
+  converter.convert("<a> ::= b\n<c> ::= d ]\n", {.inputName = "bad"}, converted);
+  EXPECT_FALSE(converted);
+  EXPECT_THAT(converted.text, IsEmpty());
+  ASSERT_THAT(converted.diagnostics, SizeIs(1));
+  EXPECT_THAT(converted.diagnostics[0], StartsWith("error at bad:2."));
+
+  converter.convert("<a> ::= b", {.stream = true, .numJobs = 2}, converted);
+  EXPECT_FALSE(converted);
+  EXPECT_THAT(converted.diagnostics, ElementsAre("stream can't be used with numJobs"));
+
+  converter.convert("<e> ::= f", {}, converted);
+  ASSERT_TRUE(converted);
+  EXPECT_THAT(converted.diagnostics, IsEmpty());
+  EXPECT_EQ(converted.text, "# 1 productions\ne:\n  f\n\n");
+
+  string printed;
+  converter.convert("<a> ::= b ::=", {}, converted);
+  EXPECT_FALSE(converted);
+  converter.print([&](string_view text) {
+    printed += text;
+  });
+  EXPECT_THAT(printed, IsEmpty());
+}
+
+// c interface gives the same text and diagnostics as the c++ one
+TEST(Converter, test_3) {
+
+  auto grammar = readFile(EBNFTOBISON_DOCS_DIR "/gqlgrammar.quotedliterals.txt");
+  auto expected = convert(grammar, {.stream = true, .predictions = true});
+  ASSERT_TRUE(expected);
+
+  auto converter = ebnftobison_converter_new();
+  ASSERT_NE(converter, nullptr);
+
+  ebnftobison_options options;
+  ebnftobison_options_init(&options);
+  options.stream = 1;
+  options.predictions = 1;
+  EXPECT_EQ(ebnftobison_convert(converter, grammar.data(), grammar.size(), &options), 0);
+  size_t length;
+  auto text = ebnftobison_text(converter, &length);
+  EXPECT_EQ(string_view(text, length), expected.text);
+  EXPECT_EQ(ebnftobison_num_diagnostics(converter), 0);
+
+// a caller built against a header with fewer members has the rest defaulted
+  options.size = offsetof(ebnftobison_options, stream);
+  string small = "<a> ::= b";
+  EXPECT_EQ(ebnftobison_convert(converter, small.data(), small.size(), &options), 0);
+  EXPECT_STREQ(ebnftobison_text(converter, nullptr), "# 1 productions\na:\n  b\n\n");
+
+  string bad = "<a> ::= b ]";
+  options.size = sizeof options;
+  options.input_name = "bad";
+  EXPECT_NE(ebnftobison_convert(converter, bad.data(), bad.size(), &options), 0);
+  EXPECT_STREQ(ebnftobison_text(converter, nullptr), "");
+  ASSERT_EQ(ebnftobison_num_diagnostics(converter), 1);
+  EXPECT_THAT(ebnftobison_diagnostic(converter, 0), StartsWith("error at bad:1."));
+  EXPECT_EQ(ebnftobison_diagnostic(converter, 1), nullptr);
+
+  ebnftobison_converter_free(converter);
+}
+
+// batch outputs are the same as converting each file alone, a failed file writes nothing
+TEST(Converter, test_4) {
+
+  auto dir = filesystem::temp_directory_path() / ("ebnftobison_batch_test_" + to_string(getpid()));
+  filesystem::remove_all(dir);
+  filesystem::create_directories(dir / "out");
+
+  auto grammar = readFile(EBNFTOBISON_DOCS_DIR "/gqlgrammar.quotedliterals.txt");
+  vector<pair<string, string>> inputs = {
+    {"gql.txt", grammar},
+    {"small.txt", "<a> ::= b [ c ]\n"},
+    {"bad.txt", "<a> ::= b ]\n"},
+    {"gql2.txt", grammar},
+  };
+  for(const auto& [name, text]: inputs) {
+    ofstream(dir / name) << text;
+  }
+
+  stringstream manifest("# grammars\ngql.txt\n\nsmall.txt small.bnf\nbad.txt\n" + (dir / "gql2.txt").string() + "\n");
+  vector<BatchEntry> entries;
+  string error;
+  ASSERT_TRUE(readManifest(manifest, (dir / "manifest").string(), (dir / "out").string(), entries, error));
+  ASSERT_THAT(entries, SizeIs(4));
+  EXPECT_EQ(entries[0].input, (dir / "gql.txt").string());
+  EXPECT_EQ(entries[0].output, (dir / "out" / "gql.y").string());
+  EXPECT_EQ(entries[1].output, (dir / "small.bnf").string());
+  EXPECT_EQ(checkBatch(entries), "");
+
+  auto results = convertBatch(entries, {}, 3);
+  ASSERT_THAT(results, SizeIs(4));
+  for(size_t k: {0, 1, 3}) {
+    EXPECT_EQ(results[k].status, 0);
+    EXPECT_EQ(readFile(entries[k].output), convert(inputs[k].second).text);
+  }
+  EXPECT_NE(results[2].status, 0);
+  EXPECT_THAT(results[2].diagnostics, ElementsAre(StartsWith("error at " + entries[2].input + ":1.")));
+  EXPECT_FALSE(filesystem::exists(entries[2].output));
+  for(const auto& file: filesystem::directory_iterator(dir)) {
+    EXPECT_THAT(file.path().filename().string(), Not(HasSubstr(".tmp"))) << "temporary file left";
+  }
+  EXPECT_THAT(temporaryName("g.y"), StartsWith("g.y.tmp." + to_string(getpid()) + "."));
+  EXPECT_EQ(results[3].stats.numRulesParsed, results[0].stats.numRulesParsed);
+
+  entries.push_back({.input = entries[1].input, .output = entries[0].output});
+  EXPECT_THAT(checkBatch(entries), HasSubstr("more than one input"));
+  entries.back().output = entries[3].input;
+  EXPECT_THAT(checkBatch(entries), HasSubstr("overwrite an input"));
+// the same file named through a symlink or by a relative path
+  filesystem::create_symlink(dir / "gql.txt", dir / "link.txt");
+  entries.back().output = (dir / "link.txt").string();
+  EXPECT_THAT(checkBatch(entries), HasSubstr("overwrite an input"));
+  entries.back().output = filesystem::relative(entries[3].input).string();
+  EXPECT_THAT(checkBatch(entries), HasSubstr("overwrite an input"));
+
+  stringstream badManifest("a b c\n");
+  EXPECT_FALSE(readManifest(badManifest, "manifest", "", entries, error));
+  EXPECT_EQ(error, "manifest:1: expected input and optional output, found more");
+
+  filesystem::remove_all(dir);
+}
+
+// server answers the same as converting in process, repeated requests come from the cache
+TEST(ConversionServer, test_0) {
+
+  auto grammar = readFile(EBNFTOBISON_DOCS_DIR "/gqlgrammar.quotedliterals.txt");
+  auto expected = convert(grammar);
+  ASSERT_TRUE(expected);
+
+// converter that keeps its symbols gives the same text whatever it converted before
+  Converter warmConverter(true);
+  ConvertedGrammar converted;
+  for(string_view input: {string_view(grammar), "<a> ::= b"sv, string_view(grammar)}) {
+    warmConverter.convert(input, {}, converted);
+    ASSERT_TRUE(converted);
+    EXPECT_EQ(converted.text, convert(input).text);
+  }
+
+  string_view input;
+  ConvertOptions options;
+  string error;
+  auto request = encodeRequest("<a> ::= b\n", {.productionBudget = 5, .stream = true, .inputName = "a b"});
+  ASSERT_TRUE(decodeRequest(request, input, options, error));
+  EXPECT_EQ(input, "<a> ::= b\n");
+  EXPECT_EQ(options.productionBudget, 5);
+  EXPECT_TRUE(options.stream);
+  EXPECT_EQ(options.inputName, "a b");
+  EXPECT_FALSE(decodeRequest("jobs 0\n\n<a> ::= b", input, options, error));
+  EXPECT_EQ(error, "bad value \"0\" for option jobs");
+  EXPECT_FALSE(decodeRequest("expand-threads 9\n\n<a> ::= b", input, options, error, 8, 8));
+  EXPECT_EQ(error, "bad value \"9\" for option expand-threads, at most 8");
+  EXPECT_TRUE(decodeRequest("jobs 8\nexpand-threads 8\n\n<a> ::= b", input, options, error, 8, 8));
+
+  auto socketPath = (filesystem::temp_directory_path() / ("ebnftobison_server_test." + to_string(getpid()))).string();
+  ConversionServer server({.socketPath = socketPath, .numWorkers = 2, .maxPending = 2, .cacheSize = 4, .maxJobs = 2});
+  ASSERT_TRUE(server.listen(error)) << error;
+  jthread serverThread([&server] { server.run(); });
+
+  ConversionServer other({.socketPath = socketPath});
+  EXPECT_FALSE(other.listen(error));
+  EXPECT_THAT(error, HasSubstr("already listening"));
+
+  vector<jthread> clients;
+  for(int i = 0; i < 3; ++i) {
+    clients.emplace_back([&] {
+      ConversionClient client;
+      string error;
+      ASSERT_TRUE(client.connect(socketPath, error)) << error;
+      ConvertedGrammar converted;
+      for(int k = 0; k < 3; ++k) {
+        ASSERT_TRUE(client.convert(grammar, {}, converted));
+        ASSERT_TRUE(converted);
+        EXPECT_EQ(converted.text, expected.text);
+      }
+    });
+  }
+  clients.clear();
+
+  ConversionClient client;
+  ASSERT_TRUE(client.connect(socketPath, error)) << error;
+  bool cached;
+  ASSERT_TRUE(client.convert(grammar, {}, converted, &cached));
+  EXPECT_TRUE(cached);
+  ASSERT_TRUE(client.convert("<a> ::= b ]", {.inputName = "bad"}, converted, &cached));
+  EXPECT_FALSE(converted);
+  EXPECT_FALSE(cached);
+  EXPECT_THAT(converted.diagnostics, ElementsAre(StartsWith("error at bad:1.")));
+  EXPECT_THAT(converted.text, IsEmpty());
+
+// a request can't ask for more threads than the server allows
+  ASSERT_TRUE(client.convert(grammar, {.numJobs = 2}, converted));
+  EXPECT_TRUE(converted);
+  EXPECT_EQ(converted.text, expected.text);
+  ASSERT_TRUE(client.convert(grammar, {.numJobs = 1000000}, converted));
+  EXPECT_FALSE(converted);
+  EXPECT_THAT(converted.diagnostics, ElementsAre("bad value \"1000000\" for option jobs, at most 2"));
+  ASSERT_TRUE(client.convert(grammar, {.expandThreads = 64}, converted));
+  EXPECT_FALSE(converted);
+  EXPECT_THAT(converted.diagnostics, ElementsAre("bad value \"64\" for option expand-threads, at most 1"));
+
+  server.stop();
+  serverThread.join();
+  auto stats = server.stats();
+// the second server's check for one already listening was a connection too
+  EXPECT_EQ(stats.numConnections, 5);
+  EXPECT_EQ(stats.numRequests, 14);
+  EXPECT_GE(stats.numCacheHits, 8);
+  EXPECT_EQ(stats.numFailed, 3);
+  EXPECT_FALSE(client.convert(grammar, {}, converted));
+}
+
+// every save reconverts only the rules that changed and the output matches converting the saved file
+TEST(Converter, test_5) {
+  auto dir = filesystem::temp_directory_path() / ("ebnftobison_watch_test_" + to_string(getpid()));
+  filesystem::remove_all(dir);
+  filesystem::create_directories(dir);
+  auto input = (dir / "g.txt").string();
+  auto output = (dir / "g.y").string();
+
+  auto grammar = readFile(EBNFTOBISON_DOCS_DIR "/gqlgrammar.quotedliterals.txt");
+  ofstream(input) << grammar;
+
+  GrammarWatcher watcher(input, output, {.factorThreshold = 4});
+  string error;
+  ASSERT_TRUE(watcher.watch(error)) << error;
+
+  mutex m;
+  condition_variable eventReady;
+  vector<GrammarWatcher::Event> events;
+  thread watching([&] {
+    watcher.run([&](const GrammarWatcher::Event& event) {
+      lock_guard lock(m);
+      events.push_back(event);
+      eventReady.notify_one();
+    });
+  });
+  auto waitForEvents = [&](size_t n) {
+    unique_lock lock(m);
+    return eventReady.wait_for(lock, 10s, [&] { return events.size() >= n; });
+  };
+
+  ASSERT_TRUE(waitForEvents(1));
+  auto numRules = events[0].numRules;
+  EXPECT_GT(numRules, 0);
+  EXPECT_EQ(events[0].numRulesConverted, numRules);
+  EXPECT_EQ(readFile(output), convert(grammar, {.factorThreshold = 4}).text);
+
+// saved by writing a new file and renaming it over the old one like many editors do
+  auto edited = grammar;
+  edited.replace(edited.find("<field type list> ::="), 21, "<field type list> ::= [ a | b ] [ c | d ] e | ");
+  ofstream(input + ".new") << edited;
+  filesystem::rename(input + ".new", input);
+  ASSERT_TRUE(waitForEvents(2));
+  EXPECT_EQ(events[1].status, 0);
+  EXPECT_EQ(events[1].numRules, numRules);
+  EXPECT_EQ(events[1].numRulesConverted, 1);
+  EXPECT_EQ(readFile(output), convert(edited, {.factorThreshold = 4}).text);
+
+// a broken save leaves the output as it was
+  auto converted = readFile(output);
+  ofstream(input) << edited << "<bad> ::= ]\n";
+  ASSERT_TRUE(waitForEvents(3));
+  EXPECT_NE(events[2].status, 0);
+  EXPECT_THAT(events[2].diagnostics, ElementsAre(StartsWith("error at " + input + ":")));
+  EXPECT_EQ(readFile(output), converted);
+
+  ofstream(input) << grammar;
+  ASSERT_TRUE(waitForEvents(4));
+  EXPECT_EQ(events[3].status, 0);
+  EXPECT_EQ(events[3].numRulesConverted, 1);
+  EXPECT_EQ(readFile(output), convert(grammar, {.factorThreshold = 4}).text);
+
+  watcher.stop();
+  watching.join();
+
+// a file missing in the middle of a save converts nothing and reports no rules from the conversion before
+  filesystem::remove(input);
+  auto missing = watcher.convert();
+  EXPECT_NE(missing.status, 0);
+  EXPECT_THAT(missing.diagnostics, ElementsAre("error opening file \"" + input + "\""));
+  EXPECT_EQ(missing.numRules, 0);
+  EXPECT_EQ(missing.numRulesConverted, 0);
+  filesystem::remove_all(dir);
+}
+
+// text printed from a snapshot is the same as the converted text, a damaged snapshot isn't opened
+TEST(Converter, test_6) {
+
+  auto grammar = readFile(EBNFTOBISON_DOCS_DIR "/gqlgrammar.quotedliterals.txt");
+  Converter converter;
+  ConvertedGrammar converted;
+  converter.convert(grammar, {.factorThreshold = 4}, converted);
+  ASSERT_TRUE(converted);
+  string snapshot;
+  ASSERT_TRUE(converter.printSnapshot(snapshot));
+
+  auto printed = [](const GrammarView& view) {
+    string text;
+    for(size_t rule = 0; rule < view.numRules(); ++rule) {
+      text += "# " + to_string(view.numProductions(rule)) + " productions\n";
+      text += string(view.symbolName(view.ruleName(rule))) + ":\n";
+      for(size_t k = 0; k < view.numProductions(rule); ++k) {
+        text += k == 0? "": "|";
+        for(auto symbol: view.production(rule, k)) {
+          text += "  " + string(view.symbolName(symbol));
+        }
+        text += "\n";
+      }
+      text += "\n";
+    }
+    return text;
+  };
+
+  auto path = (filesystem::temp_directory_path() / ("ebnftobison_snapshot_test_" + to_string(getpid()))).string();
+  ofstream(path) << snapshot;
+  GrammarView view;
+  string error;
+  ASSERT_TRUE(view.open(path, error)) << error;
+  EXPECT_EQ(printed(view), converted.text);
+  EXPECT_EQ(view.numRules(), converted.stats.numRulesGenerated);
+  EXPECT_EQ(view.totalProductions(), converted.stats.numProductionsGenerated);
+
+  auto rule = view.findRule("field_type_list");
+  ASSERT_LT(rule, view.numRules());
+  EXPECT_EQ(view.symbolName(view.ruleName(rule)), "field_type_list");
+  EXPECT_EQ(view.findRule("no_such_rule"), view.numRules());
+
+  EXPECT_FALSE(view.assign(string_view(snapshot).substr(0, snapshot.size() - 8), error));
+  EXPECT_EQ(error, "snapshot is truncated");
+  auto damaged = snapshot;
+  damaged[0] = 'X';
+  EXPECT_FALSE(view.assign(damaged, error));
+  EXPECT_EQ(error, "not a snapshot");
+  damaged = snapshot;
+  reinterpret_cast<SnapshotHeader*>(damaged.data())->numProductionSymbols += 1;
+  EXPECT_FALSE(view.assign(damaged, error));
+  EXPECT_EQ(error, "snapshot sections don't match");
+// a count that would wrap around when the end entry is added
+  for(auto count: {&SnapshotHeader::numSymbols, &SnapshotHeader::numRules, &SnapshotHeader::numProductions}) {
+    damaged = snapshot;
+    reinterpret_cast<SnapshotHeader*>(damaged.data())->*count = UINT64_MAX;
+    EXPECT_FALSE(view.assign(damaged, error));
+    EXPECT_EQ(error, "snapshot section out of range");
+  }
+  EXPECT_TRUE(view.assign(snapshot, error));
+
+// stream conversions have no expanded rules to snapshot
+  converter.convert("<a> ::= b\n", {.stream = true}, converted);
+  EXPECT_FALSE(converter.printSnapshot(snapshot));
+  EXPECT_TRUE(snapshot.empty());
+
+  filesystem::remove(path);
+}
+
+// every emitter gets the same text as convert, with rules formatted on any number of threads
+TEST(Converter, test_7) {
+
+  struct StringEmitter: Emitter {
+    void emit(string&& piece) override {
+      text += piece;
+      ++numPieces;
+    }
+    bool finish() override { return true; }
+    string text;
+    size_t numPieces = 0;
+  };
+
+  auto grammar = readFile(EBNFTOBISON_DOCS_DIR "/gqlgrammar.quotedliterals.txt");
+  auto path = (filesystem::temp_directory_path() / ("ebnftobison_emitter_test_" + to_string(getpid()))).string();
+  Converter converter;
+  ConvertedGrammar converted;
+  for(ConvertOptions options: {ConvertOptions{}, ConvertOptions{.factorThreshold = 4, .predictions = true}, ConvertOptions{.stream = true}}) {
+    converter.convert(grammar, options, converted);
+    ASSERT_TRUE(converted);
+    for(size_t numThreads: {1, 2, 7}) {
+      StringEmitter stringEmitter;
+      converter.print(stringEmitter, numThreads);
+      EXPECT_EQ(stringEmitter.text, converted.text);
+      EXPECT_GT(stringEmitter.numPieces, 1);
+
+      auto fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0666);
+      ASSERT_NE(fd, -1);
+      FdEmitter fdEmitter(fd);
+      converter.print(fdEmitter, numThreads);
+      EXPECT_TRUE(fdEmitter.finish());
+      close(fd);
+      EXPECT_EQ(readFile(path), converted.text);
+
+      MappedFileEmitter mappedFileEmitter;
+      ASSERT_TRUE(mappedFileEmitter.open(path));
+      converter.print(mappedFileEmitter, numThreads);
+      EXPECT_TRUE(mappedFileEmitter.finish());
+      EXPECT_EQ(readFile(path), converted.text);
+    }
+  }
+
+// nothing is emitted after a failed conversion
+  converter.convert("<a> ::= ]", {}, converted);
+  StringEmitter stringEmitter;
+  converter.print(stringEmitter, 4);
+  EXPECT_EQ(stringEmitter.numPieces, 0);
+
+// space for a mapped file is allocated before it's written, so space that can't be allocated fails finish instead of a write to the mapping killing the process
+// /dev/full only covers an allocation that fails, a full filesystem fails the same allocation but needs a mount to test
+  converter.convert(grammar, {}, converted);
+  if(MappedFileEmitter fullEmitter; fullEmitter.open("/dev/full")) {
+    converter.print(fullEmitter);
+    EXPECT_FALSE(fullEmitter.finish());
+  }
+
+  filesystem::remove(path);
+}
+
+// server workers share converted rules through the rule cache, a request that edits one rule converts only that rule
+TEST(ConversionServer, test_1) {
+  auto dir = filesystem::temp_directory_path() / ("ebnftobison_server_rule_cache_test_" + to_string(getpid()));
+  filesystem::remove_all(dir);
+  filesystem::create_directories(dir / "cache");
+
+  string grammar = "<a> ::= b [ c ]\n\n<d> ::= e | f\n\n<g> ::= { h }...\n";
+  string edited = "<a> ::= b [ c ]\n\n<d> ::= e | f | x\n\n<g> ::= { h }...\n";
+
+  auto socketPath = (dir / "socket").string();
+  ConversionServer::Options serverOptions{.socketPath = socketPath, .numWorkers = 2, .cacheSize = 0, .ruleCacheDir = (dir / "cache").string(), .keepRules = true};
+  ConversionServer server(serverOptions);
+  string error;
+  ASSERT_TRUE(server.listen(error)) << error;
+  jthread serverThread([&server] { server.run(); });
+
+  ConversionClient client;
+  ASSERT_TRUE(client.connect(socketPath, error)) << error;
+  ConvertedGrammar converted;
+  ASSERT_TRUE(client.convert(grammar, {}, converted));
+  ASSERT_TRUE(converted);
+  EXPECT_EQ(converted.text, convert(grammar).text);
+  ASSERT_TRUE(client.convert(edited, {}, converted));
+  ASSERT_TRUE(converted);
+  EXPECT_EQ(converted.text, convert(edited).text);
+
+// streamed requests skip the rule cache
+  ASSERT_TRUE(client.convert(grammar, {.stream = true}, converted));
+  EXPECT_TRUE(converted);
+
+  server.stop();
+  serverThread.join();
+  auto stats = server.stats();
+  EXPECT_EQ(stats.numRuleCacheMisses, 4);
+  EXPECT_EQ(stats.numRuleCacheHits, 2);
+
+// another server on the same directory finds every rule
+  ConversionServer restarted(serverOptions);
+  ASSERT_TRUE(restarted.listen(error)) << error;
+  jthread restartedThread([&restarted] { restarted.run(); });
+  ConversionClient other;
+  ASSERT_TRUE(other.connect(socketPath, error)) << error;
+  ASSERT_TRUE(other.convert(edited, {}, converted));
+  ASSERT_TRUE(converted);
+  EXPECT_EQ(converted.text, convert(edited).text);
+  restarted.stop();
+  restartedThread.join();
+  EXPECT_EQ(restarted.stats().numRuleCacheMisses, 0);
+  EXPECT_EQ(restarted.stats().numRuleCacheHits, 3);
+
+  filesystem::remove_all(dir);
+}
+
+// a client that connects and sends nothing is dropped after the idle timeout so the only worker can serve the next one
+TEST(ConversionServer, test_2) {
+  auto socketPath = (filesystem::temp_directory_path() / ("ebnftobison_server_idle_test." + to_string(getpid()))).string();
+  ConversionServer server({.socketPath = socketPath, .numWorkers = 1, .idleTimeoutMillis = 200});
+  string error;
+  ASSERT_TRUE(server.listen(error)) << error;
+  jthread serverThread([&server] { server.run(); });
+
+  ConversionClient idle;
+  ASSERT_TRUE(idle.connect(socketPath, error)) << error;
+  ConversionClient client;
+  ASSERT_TRUE(client.connect(socketPath, error)) << error;
+  ConvertedGrammar converted;
+  ASSERT_TRUE(client.convert("<a> ::= b [ c ]\n", {}, converted));
+  EXPECT_TRUE(converted);
+  EXPECT_FALSE(idle.convert("<a> ::= b [ c ]\n", {}, converted));
+
+  server.stop();
+  serverThread.join();
+  EXPECT_EQ(server.stats().numConnections, 2);
+  EXPECT_EQ(server.stats().numRequests, 1);
+}
+
+// stream prints the same productions as the default mode and each of them once, bison takes a repeated production as a conflict
+TEST(Converter, test_8) {
+
+  auto grammar = readFile(EBNFTOBISON_DOCS_DIR "/gqlgrammar.quotedliterals.txt");
+
+// productions of every rule, the header gives how many lines follow the rule name since an empty production is an empty line
+  auto productions = [](const string& text) {
+    map<string, multiset<string>> rules;
+    istringstream s(text);
+    for(string line; getline(s, line);) {
+      if(!line.starts_with("# ")) {
+        continue;
+      }
+      auto numProductions = stoull(line.substr(2));
+      string name;
+      getline(s, name);
+      auto& rule = rules[name];
+      for(uint64_t k = 0; k < numProductions && getline(s, line); ++k) {
+        rule.insert(line.starts_with("|")? line.substr(1): line);
+      }
+    }
+    return rules;
+  };
+
+  auto expected = convert(grammar);
+  auto streamed = convert(grammar, {.stream = true});
+  ASSERT_TRUE(expected);
+  ASSERT_TRUE(streamed);
+  EXPECT_EQ(productions(streamed.text), productions(expected.text));
+  EXPECT_EQ(streamed.stats.numProductionsGenerated, expected.stats.numProductionsGenerated);
+
+// [a] [a] in the tree gives a twice, only one is printed
+  auto rules = productions(streamed.text);
+  for(auto name: {"insert_element_pattern_filler:", "label_and_property_set_specification:"}) {
+    const auto& rule = rules[name];
+    ASSERT_FALSE(rule.empty()) << name;
+    EXPECT_EQ(set<string>(rule.begin(), rule.end()).size(), rule.size()) << name;
+  }
+}
+
+}
@@ -0,0 +1,170 @@
+#ifndef EBNFTOBISON_API_H
+#define EBNFTOBISON_API_H
+// ebnftobison_api.h
+
+/*
+MIT License
+
+Copyright (c) 2024 Zartaj Majeed
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <istream>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "api/ebnftobison_emitter.h"
+
+// library interface of the converter for programs that convert grammars in process instead of running ebnftobison
+// only standard headers are included here, the parser, lexers and their generated headers stay behind Converter
+// a C interface to the same calls is in ebnftobison_c_api.h
+
+namespace ebnftobison {
+using namespace std;
+using namespace chrono;
+
+// same choices as the command line options of ebnftobison
+struct ConvertOptions {
+  uint64_t factorThreshold = 0;
+  uint64_t productionBudget = 0;
+  bool refuseOverBudget = false;
+// rules are kept as ebnf trees and their productions enumerated only while text is made
+// can't be used with factorThreshold, productionBudget or numJobs
+  bool stream = false;
+// predicted sizes are printed before each rule
+  bool predictions = false;
+  bool useSimdLexer = false;
+// lexer runs on a thread of its own, can't be used with numJobs
+  bool pipeline = false;
+// bison and lexer traces go to cerr
+  bool debug = false;
+  size_t numJobs = 1;
+  size_t expandThreads = 1;
+// directory of converted rules kept between runs, only rules not found there are parsed, empty for none
+// misses are parsed on numJobs threads, can't be used with stream or pipeline
+  string ruleCacheDir{};
+// rules of the last conversion are kept in the Converter and the next conversion only parses the rules that changed
+// can be used with or without ruleCacheDir but not with stream or pipeline
+  bool keepRules = false;
+// name of the input in diagnostics
+  string inputName = "inputstream";
+};
+
+// counters and timings of one conversion, the same ones ebnftobison --stats prints
+struct ConvertStats {
+  duration<double> parseTime{};
+  uint64_t numRulesParsed = 0;
+  uint64_t numRulesGenerated = 0;
+  uint64_t numProductionsGenerated = 0;
+  uint64_t numOptionalsFactored = 0;
+  uint64_t numGroupsFactored = 0;
+  uint64_t numChoiceGroups = 0;
+  uint64_t numRulesOverBudget = 0;
+  size_t numSequenceNodes = 0;
+  size_t sequenceBytes = 0;
+  uint64_t arenaAllocations = 0;
+  uint64_t arenaBytes = 0;
+  uint64_t arenaHeapChunks = 0;
+  uint64_t arenaHeapBytes = 0;
+  uint64_t numExpandTasks = 0;
+  uint64_t numExpandTasksStolen = 0;
+  duration<double> expandTaskTime{};
+  duration<double> maxExpandTaskTime{};
+  duration<double> lexerStallTime{};
+  duration<double> parserStallTime{};
+  uint64_t numRuleCacheHits = 0;
+  uint64_t numRuleCacheMisses = 0;
+};
+
+struct ConvertedGrammar {
+// 0 on success like the parser
+  int status = 0;
+// converted rules as bison grammar text, the same text ebnftobison prints after its result: line
+  string text;
+// errors in the order they happened
+  vector<string> diagnostics;
+  ConvertStats stats;
+
+  explicit operator bool() const { return status == 0; }
+};
+
+// converts grammars one after another and keeps its lexers, parser and their allocations between conversions
+// so a program converting many grammars pays for setting them up only once
+// a Converter is used by one thread at a time, separate Converters can run side by side
+class Converter {
+public:
+
+  using Write = function<void(string_view)>;
+
+// most symbols kept between conversions, the tables start over once they hold more
+  static constexpr size_t maxKeptSymbols = 1 << 20;
+
+// with keepSymbols interned symbols and normalized names are kept between conversions too
+// worth it for a long running process that converts variants of the same grammars
+  explicit Converter(bool keepSymbols = false);
+
+  Converter(const Converter&) = delete;
+  Converter& operator=(const Converter&) = delete;
+
+  ~Converter();
+
+  ConvertedGrammar convert(string_view input, const ConvertOptions& options = {});
+
+// converted is reused so its text and diagnostics keep their buffers too
+  void convert(string_view input, const ConvertOptions& options, ConvertedGrammar& converted);
+
+// input is read as it's scanned except with numJobs above 1 ruleCacheDir or keepRules that need all of it in memory first
+  void convert(istream& input, const ConvertOptions& options, ConvertedGrammar& converted);
+
+// same as convert but no text is made, the rules stay in the Converter until the next conversion
+// parse then print is how the text of a large grammar goes out without all of it being held in memory
+  void parse(string_view input, const ConvertOptions& options, ConvertedGrammar& converted);
+  void parse(istream& input, const ConvertOptions& options, ConvertedGrammar& converted);
+
+// text of the rules from the last successful parse handed to write in pieces as it's made
+  void print(const Write& write);
+
+// same text given to emitter, numThreads above 1 format shards of rules side by side except for a stream conversion
+// emitter isn't finished so more can be written to it after
+  void print(Emitter& emitter, size_t numThreads = 1);
+
+// binary snapshot of the rules from the last successful parse for GrammarView in ebnftobison_snapshot.h
+// false with out empty when there was none or it was a stream conversion that has no expanded rules
+  bool printSnapshot(string& out);
+
+private:
+
+  struct State;
+  unique_ptr<State> state;
+
+};
+
+// one conversion with a Converter of its own
+ConvertedGrammar convert(string_view input, const ConvertOptions& options = {});
+
+}
+
+#endif
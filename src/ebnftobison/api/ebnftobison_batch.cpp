@@ -0,0 +1,206 @@
+// ebnftobison_batch.cpp
+
+/*
+MIT License
+
+Copyright (c) 2024 Zartaj Majeed
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <atomic>
+#include <unistd.h>
+
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <set>
+#include <sstream>
+#include <thread>
+
+#include "api/ebnftobison_batch.h"
+#include "lexer/ebnftobison_mapped_file.h"
+
+namespace ebnftobison {
+
+namespace {
+
+// converts one entry with converter and writes the result to a temporary file renamed to the output
+BatchResult convertEntry(Converter& converter, const BatchEntry& entry, ConvertOptions& options) {
+  auto startTime = steady_clock::now();
+  BatchResult result;
+  ConvertedGrammar converted;
+  options.inputName = entry.input;
+
+// regular files are memory mapped and scanned in place like ebnftobison does for a single file
+  MappedFile mappedFile;
+  ifstream inputStream;
+  if(mappedFile.open(entry.input)) {
+    converter.parse(mappedFile.contents(), options, converted);
+  } else if(inputStream.open(entry.input); inputStream) {
+    converter.parse(inputStream, options, converted);
+  } else {
+    converted.status = 1;
+    converted.diagnostics.push_back("error opening file \""s + entry.input + "\"");
+  }
+
+  if(converted) {
+    auto temporary = temporaryName(entry.output);
+    auto out = fopen(temporary.c_str(), "w");
+    auto written = out != nullptr;
+    if(out != nullptr) {
+      converter.print([out, &written](string_view text) {
+        written = written && fwrite(text.data(), 1, text.size(), out) == text.size();
+      });
+      written = fclose(out) == 0 && written;
+    }
+    if(!written || rename(temporary.c_str(), entry.output.c_str()) != 0) {
+      remove(temporary.c_str());
+      converted.status = 1;
+      converted.diagnostics.push_back("error writing file \""s + entry.output + "\"");
+    }
+  }
+
+  result.status = converted.status;
+  result.diagnostics = std::move(converted.diagnostics);
+  result.stats = converted.stats;
+  result.time = steady_clock::now() - startTime;
+  return result;
+}
+
+}
+
+string batchOutputName(const string& input, const string& outputDir) {
+  filesystem::path output(input);
+  output.replace_extension(".y");
+  if(!outputDir.empty()) {
+    output = filesystem::path(outputDir) / output.filename();
+  }
+  return output.string();
+}
+
+bool readManifest(istream& manifest, const string& manifestName, const string& outputDir, vector<BatchEntry>& entries, string& error) {
+  auto baseDir = filesystem::path(manifestName).parent_path();
+  auto resolve = [&baseDir](const string& name) {
+    filesystem::path path(name);
+    return (path.is_relative()? baseDir / path: path).string();
+  };
+
+  string line;
+  for(size_t lineNumber = 1; getline(manifest, line); ++lineNumber) {
+    stringstream s(line);
+    string input, output, extra;
+    s >> input >> output >> extra;
+    if(input.empty() || input.front() == '#') {
+      continue;
+    }
+    if(!extra.empty()) {
+      stringstream e;
+      e << manifestName << ":" << lineNumber << ": expected input and optional output, found more";
+      error = e.str();
+      return false;
+    }
+    input = resolve(input);
+    output = output.empty()? batchOutputName(input, outputDir): resolve(output);
+    entries.push_back({.input = std::move(input), .output = std::move(output)});
+  }
+  return true;
+}
+
+filesystem::path resolvedPath(const string& name) {
+  error_code ec;
+  auto path = filesystem::weakly_canonical(name, ec);
+  if(ec) {
+    path = filesystem::absolute(name, ec).lexically_normal();
+  }
+  return path;
+}
+
+string checkBatch(const vector<BatchEntry>& entries) {
+  set<filesystem::path> inputs;
+  for(const auto& entry: entries) {
+    inputs.insert(resolvedPath(entry.input));
+  }
+  set<filesystem::path> outputs;
+  for(const auto& entry: entries) {
+    auto output = resolvedPath(entry.output);
+    if(inputs.contains(output)) {
+      return "output \""s + entry.output + "\" would overwrite an input";
+    }
+    if(!outputs.insert(output).second) {
+      return "output \""s + entry.output + "\" is written by more than one input";
+    }
+  }
+  return {};
+}
+
+string temporaryName(const string& path) {
+  return path + ".tmp." + to_string(getpid()) + "." + to_string(hash<thread::id>{}(this_thread::get_id()));
+}
+
+// a thread that finishes early takes the next entry so a few large grammars don't hold up the rest
+vector<BatchResult> convertBatch(const vector<BatchEntry>& entries, const ConvertOptions& options, size_t numThreads) {
+  vector<BatchResult> results(entries.size());
+  atomic<size_t> nextEntry{0};
+
+  auto work = [&] {
+    Converter converter;
+    auto entryOptions = options;
+    for(size_t k; (k = nextEntry++) < entries.size();) {
+      results[k] = convertEntry(converter, entries[k], entryOptions);
+    }
+  };
+
+  vector<thread> threads;
+  for(size_t i = 1; i < min(numThreads, entries.size()); ++i) {
+    threads.emplace_back(work);
+  }
+  work();
+  for(auto& t: threads) {
+    t.join();
+  }
+  return results;
+}
+
+void addStats(ConvertStats& total, const ConvertStats& stats) {
+  total.parseTime += stats.parseTime;
+  total.numRulesParsed += stats.numRulesParsed;
+  total.numRulesGenerated += stats.numRulesGenerated;
+  total.numProductionsGenerated += stats.numProductionsGenerated;
+  total.numOptionalsFactored += stats.numOptionalsFactored;
+  total.numGroupsFactored += stats.numGroupsFactored;
+  total.numChoiceGroups += stats.numChoiceGroups;
+  total.numRulesOverBudget += stats.numRulesOverBudget;
+  total.numSequenceNodes += stats.numSequenceNodes;
+  total.sequenceBytes += stats.sequenceBytes;
+  total.arenaAllocations += stats.arenaAllocations;
+  total.arenaBytes += stats.arenaBytes;
+  total.arenaHeapChunks += stats.arenaHeapChunks;
+  total.arenaHeapBytes += stats.arenaHeapBytes;
+  total.numExpandTasks += stats.numExpandTasks;
+  total.numExpandTasksStolen += stats.numExpandTasksStolen;
+  total.expandTaskTime += stats.expandTaskTime;
+  total.maxExpandTaskTime = max(total.maxExpandTaskTime, stats.maxExpandTaskTime);
+  total.lexerStallTime += stats.lexerStallTime;
+  total.parserStallTime += stats.parserStallTime;
+  total.numRuleCacheHits += stats.numRuleCacheHits;
+  total.numRuleCacheMisses += stats.numRuleCacheMisses;
+}
+
+}
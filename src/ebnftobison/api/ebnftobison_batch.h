@@ -0,0 +1,87 @@
+#ifndef EBNFTOBISON_BATCH_H
+#define EBNFTOBISON_BATCH_H
+// ebnftobison_batch.h
+
+/*
+MIT License
+
+Copyright (c) 2024 Zartaj Majeed
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <chrono>
+#include <cstddef>
+#include <filesystem>
+#include <istream>
+#include <string>
+#include <vector>
+
+#include "api/ebnftobison_api.h"
+
+namespace ebnftobison {
+using namespace std;
+using namespace chrono;
+
+// one grammar file of a batch and the file its converted rules go to
+struct BatchEntry {
+  string input;
+  string output;
+};
+
+struct BatchResult {
+// 0 on success like the parser
+  int status = 0;
+  vector<string> diagnostics;
+  ConvertStats stats;
+// time to read, convert and write this entry
+  duration<double> time{};
+};
+
+// output for an input with none given, input with its extension replaced by .y, in outputDir when that isn't empty
+string batchOutputName(const string& input, const string& outputDir);
+
+// reads a manifest of one input per line, optionally followed by whitespace and its output
+// blank lines and lines starting with # are skipped, relative paths are taken relative to the manifest's directory
+// returns false with error set for a line that has more than two paths
+bool readManifest(istream& manifest, const string& manifestName, const string& outputDir, vector<BatchEntry>& entries, string& error);
+
+// file a path names with symlinks and relative parts resolved, an absolute normal path when it can't be resolved
+filesystem::path resolvedPath(const string& name);
+
+// entries that would write the same output or overwrite an input, empty when there are none
+// paths are compared after symlinks and relative parts are resolved, so the same file named two ways is caught
+string checkBatch(const vector<BatchEntry>& entries);
+
+// name next to path for a file that is renamed to path once it's complete
+// has the process and thread in it so runs writing the same output at once don't write each other's temporary file
+string temporaryName(const string& path);
+
+// converts every entry with options on numThreads threads, each thread reuses a Converter of its own
+// rules are written to a temporary file next to the output that is renamed over it once complete,
+// so a failed conversion leaves an existing output as it was and a reader never sees a partly written one
+// options.inputName is replaced by each entry's input, results are in entry order
+vector<BatchResult> convertBatch(const vector<BatchEntry>& entries, const ConvertOptions& options, size_t numThreads);
+
+// adds counters and times of stats to total, the largest of the max times is kept
+void addStats(ConvertStats& total, const ConvertStats& stats);
+
+}
+
+#endif
@@ -0,0 +1,150 @@
+// ebnftobison_c_api.cpp
+
+/*
+MIT License
+
+Copyright (c) 2024 Zartaj Majeed
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <cstddef>
+#include <exception>
+#include <new>
+
+#include "api/ebnftobison_c_api.h"
+#include "api/ebnftobison_api.h"
+
+using namespace ebnftobison;
+
+struct ebnftobison_converter {
+  Converter converter;
+  ConvertedGrammar converted;
+};
+
+namespace {
+
+// only the members a caller built against an older header knows about are read
+ConvertOptions convertOptions(const ebnftobison_options* options) {
+  ConvertOptions convertOptions;
+  if(options == nullptr) {
+    return convertOptions;
+  }
+  auto has = [options](size_t offset, size_t size) { return options->size >= offset + size; };
+#define EBNFTOBISON_OPTION(member, to) \
+  if(has(offsetof(ebnftobison_options, member), sizeof options->member)) { \
+    to = options->member; \
+  }
+  EBNFTOBISON_OPTION(factor_threshold, convertOptions.factorThreshold)
+  EBNFTOBISON_OPTION(production_budget, convertOptions.productionBudget)
+  EBNFTOBISON_OPTION(refuse_over_budget, convertOptions.refuseOverBudget)
+  EBNFTOBISON_OPTION(stream, convertOptions.stream)
+  EBNFTOBISON_OPTION(predictions, convertOptions.predictions)
+  EBNFTOBISON_OPTION(simd_lexer, convertOptions.useSimdLexer)
+  EBNFTOBISON_OPTION(pipeline, convertOptions.pipeline)
+  EBNFTOBISON_OPTION(jobs, convertOptions.numJobs)
+  EBNFTOBISON_OPTION(expand_threads, convertOptions.expandThreads)
+  EBNFTOBISON_OPTION(keep_rules, convertOptions.keepRules)
+#undef EBNFTOBISON_OPTION
+  if(has(offsetof(ebnftobison_options, input_name), sizeof options->input_name) && options->input_name != nullptr) {
+    convertOptions.inputName = options->input_name;
+  }
+  if(has(offsetof(ebnftobison_options, rule_cache_dir), sizeof options->rule_cache_dir) && options->rule_cache_dir != nullptr) {
+    convertOptions.ruleCacheDir = options->rule_cache_dir;
+  }
+  return convertOptions;
+}
+
+// out of memory here only loses the diagnostic
+void fail(ConvertedGrammar& converted, const char* diagnostic) noexcept {
+  converted.status = -1;
+  converted.text.clear();
+  converted.diagnostics.clear();
+  try {
+    converted.diagnostics.emplace_back(diagnostic);
+  } catch(...) {
+  }
+}
+
+}
+
+extern "C" {
+
+void ebnftobison_options_init(ebnftobison_options* options) {
+  ConvertOptions defaults;
+  *options = {
+    .size = sizeof(ebnftobison_options),
+    .factor_threshold = defaults.factorThreshold,
+    .production_budget = defaults.productionBudget,
+    .refuse_over_budget = defaults.refuseOverBudget,
+    .stream = defaults.stream,
+    .predictions = defaults.predictions,
+    .simd_lexer = defaults.useSimdLexer,
+    .pipeline = defaults.pipeline,
+    .jobs = defaults.numJobs,
+    .expand_threads = defaults.expandThreads,
+    .input_name = nullptr,
+    .rule_cache_dir = nullptr,
+    .keep_rules = defaults.keepRules,
+  };
+}
+
+ebnftobison_converter* ebnftobison_converter_new(void) {
+  try {
+    return new ebnftobison_converter;
+  } catch(...) {
+    return nullptr;
+  }
+}
+
+void ebnftobison_converter_free(ebnftobison_converter* converter) {
+  delete converter;
+}
+
+int ebnftobison_convert(ebnftobison_converter* converter, const char* input, size_t length, const ebnftobison_options* options) {
+  auto& converted = converter->converted;
+  try {
+    converter->converter.convert({input, length}, convertOptions(options), converted);
+  } catch(const exception& e) {
+    fail(converted, e.what());
+  } catch(...) {
+    fail(converted, "unknown error");
+  }
+  return converted.status;
+}
+
+const char* ebnftobison_text(const ebnftobison_converter* converter, size_t* length) {
+  if(length != nullptr) {
+    *length = converter->converted.text.size();
+  }
+  return converter->converted.text.c_str();
+}
+
+size_t ebnftobison_num_diagnostics(const ebnftobison_converter* converter) {
+  return converter->converted.diagnostics.size();
+}
+
+const char* ebnftobison_diagnostic(const ebnftobison_converter* converter, size_t index) {
+  if(index >= converter->converted.diagnostics.size()) {
+    return nullptr;
+  }
+  return converter->converted.diagnostics[index].c_str();
+}
+
+}
@@ -0,0 +1,90 @@
+#ifndef EBNFTOBISON_C_API_H
+#define EBNFTOBISON_C_API_H
+// ebnftobison_c_api.h
+
+/*
+MIT License
+
+Copyright (c) 2024 Zartaj Majeed
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+C interface of the converter library for callers that can't use C++ or need a stable ABI
+a converter handle wraps an ebnftobison::Converter and keeps the result of its last conversion
+strings returned are owned by the handle and stay valid until its next conversion or until it's freed
+no C++ exception ever leaves these functions, a failure is reported as a nonzero status with a diagnostic
+*/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct ebnftobison_converter ebnftobison_converter;
+
+/*
+new members are only ever added at the end, size is set by ebnftobison_options_init so a library built with more members can tell what the caller knows about
+*/
+typedef struct ebnftobison_options {
+  size_t size;
+  uint64_t factor_threshold;
+  uint64_t production_budget;
+  int refuse_over_budget;
+  int stream;
+  int predictions;
+  int simd_lexer;
+  int pipeline;
+  size_t jobs;
+  size_t expand_threads;
+/* name of the input in diagnostics, NULL for the default */
+  const char* input_name;
+/* directory of converted rules kept between runs, NULL for none */
+  const char* rule_cache_dir;
+/* rules of the last conversion are kept by the converter so the next one only converts the rules that changed */
+  int keep_rules;
+} ebnftobison_options;
+
+/* same defaults as ebnftobison::ConvertOptions */
+void ebnftobison_options_init(ebnftobison_options* options);
+
+/* NULL if out of memory */
+ebnftobison_converter* ebnftobison_converter_new(void);
+
+void ebnftobison_converter_free(ebnftobison_converter* converter);
+
+/* converts length bytes of input, options may be NULL for the defaults, returns 0 on success */
+int ebnftobison_convert(ebnftobison_converter* converter, const char* input, size_t length, const ebnftobison_options* options);
+
+/* bison grammar text of the last conversion, empty if it failed, length may be NULL */
+const char* ebnftobison_text(const ebnftobison_converter* converter, size_t* length);
+
+size_t ebnftobison_num_diagnostics(const ebnftobison_converter* converter);
+
+/* NULL if index is out of range */
+const char* ebnftobison_diagnostic(const ebnftobison_converter* converter, size_t index);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
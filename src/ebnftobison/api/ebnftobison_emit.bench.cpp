@@ -0,0 +1,212 @@
+// ebnftobison_emit.bench.cpp
+
+/*
+MIT License
+
+Copyright (c) 2024 Zartaj Majeed
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <cstdio>
+#include <cstdlib>
+#include <chrono>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <algorithm>
+
+#include <fcntl.h>
+#include <getopt.h>
+#include <unistd.h>
+
+#include "api/ebnftobison_api.h"
+#include "api/ebnftobison_emitter.h"
+#include "lexer/ebnftobison_mapped_file.h"
+
+using namespace std;
+using namespace ebnftobison;
+
+namespace {
+
+// time to print converted rules with each output backend, the grammar is parsed once before any timing so only emission is measured
+// format only builds the text and drops it, the rest write it to a temporary file
+
+// drops text so only formatting is timed
+class NullEmitter: public Emitter {
+public:
+
+  void emit(string&& text) override {
+    numBytes += text.size();
+  }
+
+  bool finish() override { return true; }
+
+  size_t numBytes = 0;
+
+};
+
+template<typename F>
+void run(const string& name, int iterations, F printOnce) {
+  vector<double> secs;
+  auto failed = false;
+  for(int i = 0; i < iterations; ++i) {
+    auto startTime = chrono::steady_clock::now();
+    failed |= !printOnce();
+    auto endTime = chrono::steady_clock::now();
+    secs.push_back(chrono::duration<double>(endTime - startTime).count());
+  }
+  ranges::sort(secs);
+  double total = 0;
+  for(auto s: secs) {
+    total += s;
+  }
+  printf("%-16s mean %.6f secs, median %.6f secs, min %.6f secs, max %.6f secs%s\n", name.c_str(), total / secs.size(), secs[secs.size() / 2], secs.front(), secs.back(), failed? " (output failed)": "");
+}
+
+void usage() {
+  puts("usage: ebnftobison_emit.bench [-i iterations] [-t threads] [-f n] [-b n] [grammar_file]");
+  puts("convert grammar_file once and report the time to print its rules with each output backend");
+  puts("format: build the text and drop it, stdio: fwrite each piece like ebnftobison used to, writev: FdEmitter, mmap: MappedFileEmitter");
+  puts("-i, --iterations: number of prints of each kind, default 20");
+  puts("-t, --threads: also format on this many threads, default 4");
+  puts("-f, --factor-threshold: factor threshold of the conversion, default 0");
+  puts("-b, --budget: production budget of the conversion, default 0");
+  puts("grammar_file: defaults to docs/gqlgrammar.quotedliterals.txt");
+  puts("-h, --help: print this help");
+}
+
+}
+
+int main(int argc, char* argv[]) {
+
+  int iterations = 20;
+  size_t numThreads = 4;
+  ConvertOptions options;
+  string inputFile = EBNFTOBISON_DOCS_DIR "/gqlgrammar.quotedliterals.txt";
+
+  option longOptions[] = {
+    {"iterations", required_argument, nullptr, 'i'},
+    {"threads", required_argument, nullptr, 't'},
+    {"factor-threshold", required_argument, nullptr, 'f'},
+    {"budget", required_argument, nullptr, 'b'},
+    {"help", no_argument, nullptr, 'h'},
+    {}
+  };
+
+  for(int opt; (opt = getopt_long(argc, argv, "i:t:f:b:h", longOptions, nullptr)) != -1;) {
+    switch(opt) {
+    case 'i':
+      iterations = atoi(optarg);
+      break;
+    case 't':
+      numThreads = max(strtoull(optarg, nullptr, 10), 1ull);
+      break;
+    case 'f':
+      options.factorThreshold = strtoull(optarg, nullptr, 10);
+      break;
+    case 'b':
+      options.productionBudget = strtoull(optarg, nullptr, 10);
+      break;
+    case 'h':
+      usage();
+      exit(0);
+    default:
+      usage();
+      exit(1);
+    }
+  }
+
+  if(optind < argc) {
+    inputFile = argv[optind];
+  }
+
+  if(iterations < 1) {
+    fprintf(stderr, "iterations must be at least 1\n");
+    exit(1);
+  }
+
+  MappedFile mappedFile;
+  if(!mappedFile.open(inputFile)) {
+    fprintf(stderr, "could not map %s\n", inputFile.c_str());
+    exit(1);
+  }
+
+  Converter converter;
+  ConvertedGrammar converted;
+  converter.parse(mappedFile.contents(), options, converted);
+  if(!converted) {
+    fprintf(stderr, "conversion of %s failed\n", inputFile.c_str());
+    exit(1);
+  }
+  NullEmitter sizer;
+  converter.print(sizer);
+
+  auto outputFile = (filesystem::temp_directory_path() / ("ebnftobison_emit_bench_" + to_string(getpid()) + ".y")).string();
+  printf("%s: %lu rules, %lu productions, %zu bytes of text, %d iterations\n", inputFile.c_str(), converted.stats.numRulesGenerated, converted.stats.numProductionsGenerated, sizer.numBytes, iterations);
+
+  for(auto threads: {size_t{1}, numThreads}) {
+    if(threads == numThreads && numThreads == 1) {
+      break;
+    }
+    auto suffix = threads == 1? string(): " " + to_string(threads) + "t";
+
+    run("format" + suffix, iterations, [&] {
+      NullEmitter emitter;
+      converter.print(emitter, threads);
+      return emitter.numBytes == sizer.numBytes;
+    });
+
+    if(threads == 1) {
+      run("stdio", iterations, [&] {
+        auto out = fopen(outputFile.c_str(), "w");
+        if(out == nullptr) {
+          return false;
+        }
+        converter.print([out](string_view text) {
+          fwrite(text.data(), 1, text.size(), out);
+        });
+        return fclose(out) == 0;
+      });
+    }
+
+    run("writev" + suffix, iterations, [&] {
+      auto fd = open(outputFile.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0666);
+      if(fd == -1) {
+        return false;
+      }
+      FdEmitter emitter(fd);
+      converter.print(emitter, threads);
+      auto written = emitter.finish();
+      return close(fd) == 0 && written;
+    });
+
+    run("mmap" + suffix, iterations, [&] {
+      MappedFileEmitter emitter;
+      if(!emitter.open(outputFile)) {
+        return false;
+      }
+      converter.print(emitter, threads);
+      return emitter.finish();
+    });
+  }
+
+  filesystem::remove(outputFile);
+}
@@ -0,0 +1,160 @@
+// ebnftobison_emitter.cpp
+
+/*
+MIT License
+
+Copyright (c) 2024 Zartaj Majeed
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <fcntl.h>
+#include <limits.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#include "api/ebnftobison_emitter.h"
+
+namespace ebnftobison {
+
+void FdEmitter::emit(string&& text) {
+  if(text.empty()) {
+    return;
+  }
+  heldBytes += text.size();
+  held.push_back(std::move(text));
+  if(heldBytes >= batchBytes || held.size() >= IOV_MAX) {
+    writeHeld();
+  }
+}
+
+bool FdEmitter::finish() {
+  writeHeld();
+  return !failed;
+}
+
+// writev can write less than asked, what's left of a partly written piece goes out with the next call
+void FdEmitter::writeHeld() {
+  vector<iovec> iov;
+  iov.reserve(held.size());
+  for(auto& text: held) {
+    iov.push_back({.iov_base = text.data(), .iov_len = text.size()});
+  }
+  for(size_t i = 0; i < iov.size() && !failed;) {
+    auto n = writev(fd, iov.data() + i, min<size_t>(iov.size() - i, IOV_MAX));
+    if(n == -1) {
+      failed = errno != EINTR;
+      continue;
+    }
+    if(n == 0) {
+      failed = true;
+      continue;
+    }
+    for(auto written = static_cast<size_t>(n); written > 0 && i < iov.size();) {
+      auto k = min(written, iov[i].iov_len);
+      iov[i].iov_base = static_cast<char*>(iov[i].iov_base) + k;
+      iov[i].iov_len -= k;
+      written -= k;
+      if(iov[i].iov_len == 0) {
+        ++i;
+      }
+    }
+  }
+  held.clear();
+  heldBytes = 0;
+}
+
+MappedFileEmitter::~MappedFileEmitter() {
+  close();
+}
+
+bool MappedFileEmitter::open(const string& filename) {
+  close();
+  failed = false;
+  length = 0;
+  fd = ::open(filename.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0666);
+  return fd != -1;
+}
+
+void MappedFileEmitter::emit(string&& text) {
+  if(failed || fd == -1) {
+    failed = true;
+    return;
+  }
+  if(length + text.size() > capacity && !grow(length + text.size())) {
+    failed = true;
+    return;
+  }
+  memcpy(data + length, text.data(), text.size());
+  length += text.size();
+}
+
+bool MappedFileEmitter::finish() {
+  if(fd == -1) {
+    return false;
+  }
+  if(data != nullptr) {
+    munmap(data, capacity);
+    data = nullptr;
+    capacity = 0;
+  }
+  failed = ftruncate(fd, length) == -1 || failed;
+  failed = ::close(fd) == -1 || failed;
+  fd = -1;
+  return !failed;
+}
+
+// blocks of the file are allocated before it's mapped so every page of the mapping is backed by disk
+// a sparse file from ftruncate would only get its blocks when a page is written, and a full disk would be a SIGBUS then instead of an error here
+bool MappedFileEmitter::grow(size_t size) {
+  auto newCapacity = max({size, 2 * capacity, size_t{1} << 20});
+  if(data != nullptr) {
+    munmap(data, capacity);
+    data = nullptr;
+    capacity = 0;
+  }
+  if(posix_fallocate(fd, 0, newCapacity) != 0) {
+    return false;
+  }
+  auto p = mmap(nullptr, newCapacity, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if(p == MAP_FAILED) {
+    return false;
+  }
+  data = static_cast<char*>(p);
+  capacity = newCapacity;
+  return true;
+}
+
+void MappedFileEmitter::close() {
+  if(data != nullptr) {
+    munmap(data, capacity);
+    data = nullptr;
+    capacity = 0;
+  }
+  if(fd != -1) {
+    ::close(fd);
+    fd = -1;
+  }
+}
+
+}
@@ -0,0 +1,110 @@
+#ifndef EBNFTOBISON_EMITTER_H
+#define EBNFTOBISON_EMITTER_H
+// ebnftobison_emitter.h
+
+/*
+MIT License
+
+Copyright (c) 2024 Zartaj Majeed
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <sys/uio.h>
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace ebnftobison {
+using namespace std;
+
+// where printed text goes, text is handed over in order in pieces of about GrammarPrinter::flushSize or larger
+// a piece is given away so an emitter can hold on to it and write several at once
+class Emitter {
+public:
+
+  virtual ~Emitter() = default;
+
+  virtual void emit(string&& text) = 0;
+
+// writes whatever is held back, false when any text couldn't be written
+  virtual bool finish() = 0;
+
+};
+
+// writes to a descriptor it doesn't own, pieces are gathered and written together with writev once batchBytes are held
+class FdEmitter: public Emitter {
+public:
+
+  static constexpr size_t batchBytes = 1 << 20;
+
+  explicit FdEmitter(int fd): fd(fd) {}
+
+  void emit(string&& text) override;
+
+  bool finish() override;
+
+private:
+
+  void writeHeld();
+
+  int fd;
+  vector<string> held;
+  size_t heldBytes = 0;
+  bool failed = false;
+
+};
+
+// copies text straight into a memory mapping of a file it creates, the mapping grows by doubling
+// the file is cut to the length of the text at finish
+class MappedFileEmitter: public Emitter {
+public:
+
+  MappedFileEmitter() = default;
+
+  MappedFileEmitter(const MappedFileEmitter&) = delete;
+  MappedFileEmitter& operator=(const MappedFileEmitter&) = delete;
+
+  ~MappedFileEmitter() override;
+
+// creates or truncates filename, false when it can't
+  bool open(const string& filename);
+
+  void emit(string&& text) override;
+
+  bool finish() override;
+
+private:
+
+  bool grow(size_t size);
+
+  void close();
+
+  int fd = -1;
+  char* data = nullptr;
+  size_t capacity = 0;
+  size_t length = 0;
+  bool failed = false;
+
+};
+
+}
+
+#endif
@@ -0,0 +1,323 @@
+// ebnftobison_printer.cpp
+
+/*
+MIT License
+
+Copyright (c) 2024 Zartaj Majeed
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+#include "converter/ebnftobison_enumerator.h"
+#include "api/ebnftobison_printer.h"
+#include "api/ebnftobison_snapshot.h"
+
+namespace ebnftobison {
+
+namespace {
+
+// sorted rules of result, same order printRules uses
+vector<const Rule::value_type*> sortedRules(const BisonParam& bisonParam) {
+  const auto& symbols = bisonParam.symbols;
+  vector<const Rule::value_type*> rules;
+  rules.reserve(bisonParam.result.size());
+  for(const auto& r: bisonParam.result) {
+    rules.push_back(&r);
+  }
+  ranges::sort(rules, {}, [&symbols](const Rule::value_type* r) -> const string& { return symbols.name(r->first); });
+  return rules;
+}
+
+template<typename T>
+void appendSection(string& out, uint64_t& offset, const vector<T>& v) {
+  out.resize((out.size() + 7) & ~size_t{7});
+  offset = out.size();
+  out.append(reinterpret_cast<const char*>(v.data()), v.size() * sizeof(T));
+}
+
+}
+
+GrammarPrinter::GrammarPrinter(const BisonParam& bisonParam, bool printPredictions, string& out, Write write): bisonParam(bisonParam), printPredictions(printPredictions), out(out), write(std::move(write)) {
+}
+
+GrammarPrinter::GrammarPrinter(const BisonParam& bisonParam, bool printPredictions, string& out, Emitter& emitter): bisonParam(bisonParam), printPredictions(printPredictions), out(out), emitter(&emitter) {
+}
+
+// rules and their productions are printed in name order, symbol ids only reflect order of first appearance
+void GrammarPrinter::printRules() {
+  printRules(sortedRules(bisonParam), bisonParam.symbols.nameRanks());
+}
+
+void GrammarPrinter::printRules(span<const Rule::value_type* const> rules, const vector<uint32_t>& symbolRanks) {
+// productions are flattened one rule at a time and sorted in name order of symbols
+  FlatProductions flatProductions(bisonParam.sequences);
+
+  for(auto r: rules) {
+    const auto& [rule, production] = *r;
+    printHeader(rule, production.size());
+    if(production.empty()) {
+      endLine();
+      continue;
+    }
+    flatProductions.assign(production);
+    flatProductions.sort(symbolRanks);
+
+    for(size_t i = 0; i < flatProductions.size(); ++i) {
+      printProduction(i == 0, flatProductions[i]);
+    }
+    endLine();
+  }
+}
+
+// only one production at a time is ever built
+void GrammarPrinter::printRuleTrees() {
+  const auto& symbols = bisonParam.symbols;
+  vector<const pair<const SymbolId, Expr>*> rules;
+  rules.reserve(bisonParam.ruleTrees.size());
+  for(const auto& r: bisonParam.ruleTrees) {
+    rules.push_back(&r);
+  }
+  ranges::sort(rules, {}, [&symbols](const pair<const SymbolId, Expr>* r) -> const string& { return symbols.name(r->first); });
+
+// a rule is enumerated twice, first to count its distinct productions for the header and then to print each one where it first comes up
+// bison takes a repeated production as a reduce/reduce conflict, a tree like [a] [a] has two
+  vector<SymbolId> productionSymbols;
+  ProductionSet distinct;
+  for(auto r: rules) {
+    const auto& [rule, expr] = *r;
+    printHeader(rule, countDistinctProductions(expr, distinct));
+    ProductionEnumerator productions(expr);
+    for(bool first = true; productions.next(productionSymbols);) {
+      if(distinct.erase(productionSymbols)) {
+        printProduction(first, productionSymbols);
+        first = false;
+      }
+    }
+    endLine();
+  }
+}
+
+// an emitter keeps the piece it's given so the next one is built in a fresh buffer
+void GrammarPrinter::flush() {
+  if(out.empty()) {
+    return;
+  }
+  if(emitter != nullptr) {
+    emitter->emit(std::move(out));
+    out = string();
+    out.reserve(2 * flushSize);
+  } else if(write) {
+    write(out);
+    out.clear();
+  }
+}
+
+// helper rules made during conversion have no prediction
+void GrammarPrinter::printPrediction(SymbolId rule) {
+  if(auto i = bisonParam.predictedSizes.find(rule); i != bisonParam.predictedSizes.end()) {
+    const auto& predictedSize = i->second;
+    out += "# predicted ";
+    appendNumber(predictedSize.numProductions);
+    out += " productions, ";
+    appendNumber(predictedSize.numSymbols);
+    out += " symbols, ";
+    appendNumber(predictedSize.numListProductions);
+    out += " list rule productions";
+    endLine();
+  }
+}
+
+void GrammarPrinter::printHeader(SymbolId rule, uint64_t numProductions) {
+  if(printPredictions) {
+    printPrediction(rule);
+  }
+  out += "# ";
+  appendNumber(numProductions);
+  out += " productions";
+  endLine();
+  out += bisonParam.symbols.name(rule);
+  out += ':';
+  endLine();
+}
+
+void GrammarPrinter::printProduction(bool first, span<const SymbolId> productionSymbols) {
+  if(!first) {
+    out += '|';
+  }
+  for(auto elt: productionSymbols) {
+    out += "  ";
+    out += bisonParam.symbols.name(elt);
+  }
+  endLine();
+}
+
+void GrammarPrinter::appendNumber(uint64_t n) {
+  char digits[20];
+  auto end = to_chars(digits, digits + sizeof digits, n).ptr;
+  out.append(digits, end);
+}
+
+void GrammarPrinter::endLine() {
+  out += '\n';
+  if(out.size() >= flushSize) {
+    flush();
+  }
+}
+
+// shards are several times the number of threads and split by production count so one long rule doesn't hold up the rest
+void printRulesParallel(const BisonParam& bisonParam, bool printPredictions, Emitter& emitter, size_t numThreads) {
+  auto rules = sortedRules(bisonParam);
+  auto symbolRanks = bisonParam.symbols.nameRanks();
+  if(numThreads <= 1 || rules.size() < 2) {
+    string out;
+    GrammarPrinter printer(bisonParam, printPredictions, out, emitter);
+    printer.printRules(rules, symbolRanks);
+    printer.flush();
+    return;
+  }
+
+  uint64_t totalWeight = 0;
+  for(auto r: rules) {
+    totalWeight += r->second.size() + 1;
+  }
+  auto numShards = min(rules.size(), 8 * numThreads);
+  vector<size_t> shardStarts{0};
+  uint64_t weight = 0;
+  for(size_t i = 0; i < rules.size() && shardStarts.size() < numShards; ++i) {
+    weight += rules[i]->second.size() + 1;
+    if(weight * numShards >= totalWeight * shardStarts.size()) {
+      shardStarts.push_back(i + 1);
+    }
+  }
+  if(shardStarts.back() != rules.size()) {
+    shardStarts.push_back(rules.size());
+  }
+  numShards = shardStarts.size() - 1;
+
+  vector<string> texts(numShards);
+  vector<bool> done(numShards);
+  mutex m;
+  condition_variable shardDone;
+  atomic<size_t> nextShard{0};
+  auto work = [&] {
+    for(size_t k; (k = nextShard++) < numShards;) {
+      string out;
+      GrammarPrinter printer(bisonParam, printPredictions, out);
+      printer.printRules(span(rules).subspan(shardStarts[k], shardStarts[k + 1] - shardStarts[k]), symbolRanks);
+      lock_guard lock(m);
+      texts[k] = std::move(out);
+      done[k] = true;
+      shardDone.notify_one();
+    }
+  };
+
+// this thread only hands finished shards to emitter so writing overlaps with formatting
+  vector<thread> threads;
+  for(size_t i = 0; i < min(numThreads, numShards); ++i) {
+    threads.emplace_back(work);
+  }
+  for(size_t k = 0; k < numShards; ++k) {
+    string text;
+    {
+      unique_lock lock(m);
+      shardDone.wait(lock, [&] { return done[k]; });
+      text = std::move(texts[k]);
+    }
+    emitter.emit(std::move(text));
+  }
+  for(auto& t: threads) {
+    t.join();
+  }
+}
+
+// symbols are numbered as they're first used so a snapshot only has the symbols of its own rules
+void printSnapshot(const BisonParam& bisonParam, string& out) {
+  const auto& symbols = bisonParam.symbols;
+  auto symbolRanks = symbols.nameRanks();
+  FlatProductions flatProductions(bisonParam.sequences);
+
+  constexpr auto unnumbered = ~uint32_t{};
+  vector<uint32_t> snapshotIds(symbols.size(), unnumbered);
+  vector<SymbolId> used;
+  auto snapshotId = [&](SymbolId id) {
+    if(snapshotIds[id] == unnumbered) {
+      snapshotIds[id] = used.size();
+      used.push_back(id);
+    }
+    return snapshotIds[id];
+  };
+
+  vector<uint32_t> ruleNames;
+  vector<uint64_t> ruleProductions{0};
+  vector<uint64_t> productionSymbols{0};
+  vector<uint32_t> productionSymbolIds;
+  for(auto r: sortedRules(bisonParam)) {
+    const auto& [rule, production] = *r;
+    ruleNames.push_back(snapshotId(rule));
+    flatProductions.assign(production);
+    flatProductions.sort(symbolRanks);
+    for(size_t i = 0; i < flatProductions.size(); ++i) {
+      for(auto symbol: flatProductions[i]) {
+        productionSymbolIds.push_back(snapshotId(symbol));
+      }
+      productionSymbols.push_back(productionSymbolIds.size());
+    }
+    ruleProductions.push_back(productionSymbols.size() - 1);
+  }
+
+  vector<uint64_t> nameOffsets{0};
+  vector<char> names;
+  for(auto id: used) {
+    const auto& name = symbols.name(id);
+    names.insert(names.end(), name.begin(), name.end());
+    names.push_back('\0');
+    nameOffsets.push_back(names.size());
+  }
+
+  SnapshotHeader header{};
+  memcpy(header.magic, SnapshotHeader::expectedMagic, sizeof header.magic);
+  header.version = SnapshotHeader::currentVersion;
+  header.byteOrder = SnapshotHeader::expectedByteOrder;
+  header.numSymbols = used.size();
+  header.numRules = ruleNames.size();
+  header.numProductions = productionSymbols.size() - 1;
+  header.numProductionSymbols = productionSymbolIds.size();
+  header.nameBytes = names.size();
+
+  out.assign(sizeof header, '\0');
+  appendSection(out, header.nameOffsets, nameOffsets);
+  appendSection(out, header.ruleProductions, ruleProductions);
+  appendSection(out, header.productionSymbols, productionSymbols);
+  appendSection(out, header.ruleNames, ruleNames);
+  appendSection(out, header.symbols, productionSymbolIds);
+  appendSection(out, header.names, names);
+  header.fileSize = out.size();
+  memcpy(out.data(), &header, sizeof header);
+}
+
+}
@@ -0,0 +1,100 @@
+#ifndef EBNFTOBISON_PRINTER_H
+#define EBNFTOBISON_PRINTER_H
+// ebnftobison_printer.h
+
+/*
+MIT License
+
+Copyright (c) 2024 Zartaj Majeed
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "ebnftobison.bison.h"
+#include "api/ebnftobison_emitter.h"
+
+namespace ebnftobison {
+using namespace std;
+
+// writes the converted rules of a BisonParam as bison grammar text
+// text is built up in out, when write is given out is handed to it and cleared each time it grows past flushSize
+// so a large grammar can go to a file without all of its text being held at once
+class GrammarPrinter {
+public:
+
+  using Write = function<void(string_view)>;
+
+  static constexpr size_t flushSize = 1 << 16;
+
+  GrammarPrinter(const BisonParam& bisonParam, bool printPredictions, string& out, Write write = {});
+
+// text is given to emitter a piece at a time instead, out is only where the next piece is built
+  GrammarPrinter(const BisonParam& bisonParam, bool printPredictions, string& out, Emitter& emitter);
+
+// rules of result in name order, productions of each rule in name order of their symbols
+  void printRules();
+
+// only the given rules of result in the given order, symbolRanks are from SymbolTable::nameRanks
+  void printRules(span<const Rule::value_type* const> rules, const vector<uint32_t>& symbolRanks);
+
+// rules of ruleTrees, distinct productions of each rule in the enumeration order of its tree
+  void printRuleTrees();
+
+// hands whatever is left in out to write
+  void flush();
+
+private:
+
+  void printPrediction(SymbolId rule);
+
+  void printHeader(SymbolId rule, uint64_t numProductions);
+
+  void printProduction(bool first, span<const SymbolId> productionSymbols);
+
+  void appendNumber(uint64_t n);
+
+// every line ends here so out is only checked against flushSize once per line
+  void endLine();
+
+  const BisonParam& bisonParam;
+  bool printPredictions;
+  string& out;
+  Write write;
+  Emitter* emitter = nullptr;
+
+};
+
+// prints the rules of result like printRules with numThreads threads formatting shards of consecutive rules
+// shards are handed to emitter in rule order as soon as they and every shard before them are done
+void printRulesParallel(const BisonParam& bisonParam, bool printPredictions, Emitter& emitter, size_t numThreads);
+
+// binary snapshot of the rules of result in the order printRules prints them, read back with GrammarView
+void printSnapshot(const BisonParam& bisonParam, string& out);
+
+}
+
+#endif
@@ -0,0 +1,204 @@
+// ebnftobison_server.bench.cpp
+
+/*
+MIT License
+
+Copyright (c) 2024 Zartaj Majeed
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <cstdio>
+#include <cstdlib>
+#include <chrono>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include <algorithm>
+
+#include <getopt.h>
+#include <unistd.h>
+
+#include "api/ebnftobison_server.h"
+#include "lexer/ebnftobison_mapped_file.h"
+
+using namespace std;
+using namespace ebnftobison;
+
+namespace {
+
+// load generator for the conversion server, clients send requests back to back and latency percentiles are reported
+// without a socket to connect to a server is started in this process
+
+struct Client {
+  vector<double> secs;
+  uint64_t numCached = 0;
+  uint64_t numFailed = 0;
+};
+
+// a header line differing per request makes every grammar text distinct so no response comes from the cache
+void runClient(const string& socketPath, string_view grammar, int numRequests, bool unique, size_t clientNumber, Client& client) {
+  ConversionClient connection;
+  string error;
+  if(!connection.connect(socketPath, error)) {
+    fprintf(stderr, "%s\n", error.c_str());
+    client.numFailed = numRequests;
+    return;
+  }
+  ConvertedGrammar converted;
+  string input;
+  for(int i = 0; i < numRequests; ++i) {
+    input.clear();
+    if(unique) {
+      input = "request " + to_string(clientNumber) + " " + to_string(i) + "\n";
+    }
+    input += grammar;
+    bool cached;
+    auto startTime = chrono::steady_clock::now();
+    auto ok = connection.convert(input, {}, converted, &cached);
+    auto endTime = chrono::steady_clock::now();
+    client.secs.push_back(chrono::duration<double>(endTime - startTime).count());
+    client.numCached += cached;
+    client.numFailed += !ok || !converted;
+  }
+}
+
+double percentile(const vector<double>& sorted, double p) {
+  return sorted[min(sorted.size() - 1, static_cast<size_t>(p * sorted.size()))];
+}
+
+void usage() {
+  puts("usage: ebnftobison_server.bench [-c clients] [-n requests] [-w workers] [-s socket] [-u] [grammar_file]");
+  puts("send conversion requests to a server from concurrent clients and report latency percentiles");
+  puts("-c, --clients: number of concurrent client connections, default 4");
+  puts("-n, --requests: requests sent by each client, default 50");
+  puts("-w, --workers: worker threads of the server started when no socket is given, default 4");
+  puts("-s, --socket: socket of a running server, ebnftobison --serve socket");
+  puts("-u, --unique: make every request distinct so none is answered from the cache");
+  puts("grammar_file: defaults to docs/gqlgrammar.quotedliterals.txt");
+  puts("-h, --help: print this help");
+}
+
+}
+
+int main(int argc, char* argv[]) {
+
+  int numClients = 4;
+  int numRequests = 50;
+  size_t numWorkers = 4;
+  string socketPath;
+  bool unique = false;
+  string inputFile = EBNFTOBISON_DOCS_DIR "/gqlgrammar.quotedliterals.txt";
+
+  option longOptions[] = {
+    {"clients", required_argument, nullptr, 'c'},
+    {"requests", required_argument, nullptr, 'n'},
+    {"workers", required_argument, nullptr, 'w'},
+    {"socket", required_argument, nullptr, 's'},
+    {"unique", no_argument, nullptr, 'u'},
+    {"help", no_argument, nullptr, 'h'},
+    {}
+  };
+
+  for(int opt; (opt = getopt_long(argc, argv, "c:n:w:s:uh", longOptions, nullptr)) != -1;) {
+    switch(opt) {
+    case 'c':
+      numClients = atoi(optarg);
+      break;
+    case 'n':
+      numRequests = atoi(optarg);
+      break;
+    case 'w':
+      numWorkers = max(atoi(optarg), 1);
+      break;
+    case 's':
+      socketPath = optarg;
+      break;
+    case 'u':
+      unique = true;
+      break;
+    case 'h':
+      usage();
+      exit(0);
+    default:
+      usage();
+      exit(1);
+    }
+  }
+
+  if(optind < argc) {
+    inputFile = argv[optind];
+  }
+
+  if(numClients < 1 || numRequests < 1) {
+    fprintf(stderr, "clients and requests must be at least 1\n");
+    exit(1);
+  }
+
+  MappedFile mappedFile;
+  if(!mappedFile.open(inputFile)) {
+    fprintf(stderr, "could not map %s\n", inputFile.c_str());
+    exit(1);
+  }
+  auto grammar = mappedFile.contents();
+
+  unique_ptr<ConversionServer> server;
+  jthread serverThread;
+  if(socketPath.empty()) {
+    socketPath = "/tmp/ebnftobison_server_bench." + to_string(getpid());
+    server = make_unique<ConversionServer>(ConversionServer::Options{.socketPath = socketPath, .numWorkers = numWorkers, .maxPending = static_cast<size_t>(numClients)});
+    if(string error; !server->listen(error)) {
+      fprintf(stderr, "%s\n", error.c_str());
+      exit(1);
+    }
+    serverThread = jthread([&server] { server->run(); });
+  }
+
+  printf("%s: %zu bytes, %d clients, %d requests each%s\n", inputFile.c_str(), grammar.size(), numClients, numRequests, unique? ", every request distinct": "");
+
+  vector<Client> clients(numClients);
+  auto startTime = chrono::steady_clock::now();
+  {
+    vector<jthread> threads;
+    for(int i = 0; i < numClients; ++i) {
+      threads.emplace_back([&, i] { runClient(socketPath, grammar, numRequests, unique, i, clients[i]); });
+    }
+  }
+  auto secs = chrono::duration<double>(chrono::steady_clock::now() - startTime).count();
+
+  vector<double> latencies;
+  uint64_t numCached = 0;
+  uint64_t numFailed = 0;
+  for(const auto& client: clients) {
+    ranges::copy(client.secs, back_inserter(latencies));
+    numCached += client.numCached;
+    numFailed += client.numFailed;
+  }
+  ranges::sort(latencies);
+
+  printf("%zu requests in %.6f secs, %.1f requests/sec, %lu cached, %lu failed\n", latencies.size(), secs, latencies.size() / secs, numCached, numFailed);
+  if(!latencies.empty()) {
+    printf("latency p50 %.6f secs, p90 %.6f secs, p99 %.6f secs, max %.6f secs\n", percentile(latencies, 0.5), percentile(latencies, 0.9), percentile(latencies, 0.99), latencies.back());
+  }
+
+  if(server) {
+    server->stop();
+  }
+}
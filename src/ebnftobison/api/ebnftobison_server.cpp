@@ -0,0 +1,516 @@
+// ebnftobison_server.cpp
+
+/*
+MIT License
+
+Copyright (c) 2024 Zartaj Majeed
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <errno.h>
+#include <limits.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/uio.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <exception>
+#include <thread>
+#include <type_traits>
+
+#include "api/ebnftobison_server.h"
+
+namespace ebnftobison {
+
+namespace {
+
+bool readAll(int fd, char* data, size_t length) {
+  while(length > 0) {
+    auto n = read(fd, data, length);
+    if(n == -1 && errno == EINTR) {
+      continue;
+    }
+    if(n <= 0) {
+      return false;
+    }
+    data += n;
+    length -= n;
+  }
+  return true;
+}
+
+bool parseNumber(string_view value, auto& n) {
+  auto [end, ec] = from_chars(value.data(), value.data() + value.size(), n);
+  return ec == errc{} && end == value.data() + value.size();
+}
+
+bool parseFlag(string_view value, bool& flag) {
+  if(value != "0" && value != "1") {
+    return false;
+  }
+  flag = value == "1";
+  return true;
+}
+
+// lines are taken off the front of text one at a time, false when there is no complete line left
+bool nextLine(string_view& text, string_view& line) {
+  auto end = text.find('\n');
+  if(end == string_view::npos) {
+    return false;
+  }
+  line = text.substr(0, end);
+  text.remove_prefix(end + 1);
+  return true;
+}
+
+bool socketAddress(const string& socketPath, sockaddr_un& address, string& error) {
+  address = {};
+  address.sun_family = AF_UNIX;
+  if(socketPath.empty() || socketPath.size() >= sizeof address.sun_path) {
+    error = "socket path \"" + socketPath + "\" is empty or too long";
+    return false;
+  }
+  memcpy(address.sun_path, socketPath.c_str(), socketPath.size() + 1);
+  return true;
+}
+
+}
+
+string encodeRequest(string_view input, const ConvertOptions& options) {
+  string request;
+  request.reserve(input.size() + 256);
+  auto option = [&request](string_view name, const auto& value) {
+    request += name;
+    request += ' ';
+    if constexpr(is_same_v<decay_t<decltype(value)>, string>) {
+      request += value;
+    } else {
+      request += to_string(value);
+    }
+    request += '\n';
+  };
+  option("factor-threshold", options.factorThreshold);
+  option("budget", options.productionBudget);
+  option("refuse-over-budget", int{options.refuseOverBudget});
+  option("predict", int{options.predictions});
+  option("stream", int{options.stream});
+  option("simd-lexer", int{options.useSimdLexer});
+  option("pipeline", int{options.pipeline});
+  option("jobs", options.numJobs);
+  option("expand-threads", options.expandThreads);
+  option("name", options.inputName);
+  request += '\n';
+  request += input;
+  return request;
+}
+
+bool decodeRequest(string_view request, string_view& input, ConvertOptions& options, string& error, size_t maxJobs, size_t maxExpandThreads) {
+  options = {};
+  for(string_view line; nextLine(request, line) && !line.empty();) {
+    auto space = line.find(' ');
+    auto name = line.substr(0, space);
+    auto value = space == string_view::npos? string_view{}: line.substr(space + 1);
+    bool valid;
+    size_t limit = 0;
+    if(name == "factor-threshold") {
+      valid = parseNumber(value, options.factorThreshold);
+    } else if(name == "budget") {
+      valid = parseNumber(value, options.productionBudget);
+    } else if(name == "refuse-over-budget") {
+      valid = parseFlag(value, options.refuseOverBudget);
+    } else if(name == "predict") {
+      valid = parseFlag(value, options.predictions);
+    } else if(name == "stream") {
+      valid = parseFlag(value, options.stream);
+    } else if(name == "simd-lexer") {
+      valid = parseFlag(value, options.useSimdLexer);
+    } else if(name == "pipeline") {
+      valid = parseFlag(value, options.pipeline);
+    } else if(name == "jobs") {
+      valid = parseNumber(value, options.numJobs) && options.numJobs > 0 && options.numJobs <= maxJobs;
+      limit = maxJobs;
+    } else if(name == "expand-threads") {
+      valid = parseNumber(value, options.expandThreads) && options.expandThreads > 0 && options.expandThreads <= maxExpandThreads;
+      limit = maxExpandThreads;
+    } else if(name == "name") {
+      options.inputName = value;
+      valid = true;
+    } else {
+      error = "unknown option \"" + string(name) + "\"";
+      return false;
+    }
+    if(!valid) {
+      error = "bad value \"" + string(value) + "\" for option " + string(name);
+      if(limit != 0 && limit != SIZE_MAX) {
+        error += ", at most " + to_string(limit);
+      }
+      return false;
+    }
+  }
+  input = request;
+  return true;
+}
+
+string encodeResponseHeader(const ConvertedGrammar& converted, bool cached) {
+  string header = "status " + to_string(converted.status) + "\ncached " + (cached? "1": "0") + "\n";
+  for(const auto& diagnostic: converted.diagnostics) {
+    auto start = header.size();
+    header += "diagnostic ";
+    header += diagnostic;
+// a diagnostic has to stay on its line
+    replace(header.begin() + start, header.end(), '\n', ' ');
+    header += '\n';
+  }
+  header += '\n';
+  return header;
+}
+
+bool decodeResponse(string_view response, ConvertedGrammar& converted, bool& cached) {
+  converted.status = 0;
+  converted.diagnostics.clear();
+  cached = false;
+  string_view line;
+  if(!nextLine(response, line) || !line.starts_with("status ") || !parseNumber(line.substr(7), converted.status)) {
+    return false;
+  }
+  if(!nextLine(response, line) || !line.starts_with("cached ") || !parseFlag(line.substr(7), cached)) {
+    return false;
+  }
+  for(;;) {
+    if(!nextLine(response, line)) {
+      return false;
+    }
+    if(line.empty()) {
+      break;
+    }
+    if(!line.starts_with("diagnostic ")) {
+      return false;
+    }
+    converted.diagnostics.emplace_back(line.substr(11));
+  }
+  converted.text.assign(response);
+  return true;
+}
+
+bool readFrame(int fd, string& frame) {
+  unsigned char prefix[4];
+  if(!readAll(fd, reinterpret_cast<char*>(prefix), sizeof prefix)) {
+    return false;
+  }
+  size_t length = uint32_t{prefix[0]} << 24 | uint32_t{prefix[1]} << 16 | uint32_t{prefix[2]} << 8 | prefix[3];
+  if(length > maxFrameSize) {
+    return false;
+  }
+  frame.resize(length);
+  return readAll(fd, frame.data(), length);
+}
+
+// sendmsg with MSG_NOSIGNAL so a client that went away is an error here instead of a SIGPIPE
+bool writeFrame(int fd, const vector<string_view>& parts) {
+  size_t length = 0;
+  for(auto part: parts) {
+    length += part.size();
+  }
+  if(length > maxFrameSize) {
+    return false;
+  }
+  unsigned char prefix[4] = {
+    static_cast<unsigned char>(length >> 24),
+    static_cast<unsigned char>(length >> 16),
+    static_cast<unsigned char>(length >> 8),
+    static_cast<unsigned char>(length),
+  };
+  vector<iovec> iov;
+  iov.reserve(parts.size() + 1);
+  iov.push_back({prefix, sizeof prefix});
+  for(auto part: parts) {
+    if(!part.empty()) {
+      iov.push_back({const_cast<char*>(part.data()), part.size()});
+    }
+  }
+
+  for(size_t first = 0; first < iov.size();) {
+    msghdr message{};
+    message.msg_iov = iov.data() + first;
+    message.msg_iovlen = min(iov.size() - first, size_t{IOV_MAX});
+    auto n = sendmsg(fd, &message, MSG_NOSIGNAL);
+    if(n == -1 && errno == EINTR) {
+      continue;
+    }
+    if(n <= 0) {
+      return false;
+    }
+// skip what was sent, a partly sent part is trimmed from the front
+    for(size_t sent = n; sent > 0;) {
+      auto& v = iov[first];
+      if(sent < v.iov_len) {
+        v.iov_base = static_cast<char*>(v.iov_base) + sent;
+        v.iov_len -= sent;
+        break;
+      }
+      sent -= v.iov_len;
+      ++first;
+    }
+  }
+  return true;
+}
+
+bool ResponseCache::find(const string& request, ConvertedGrammar& converted) {
+  lock_guard lock(m);
+  auto i = index.find(request);
+  if(i == index.end()) {
+    return false;
+  }
+  entries.splice(entries.begin(), entries, i->second);
+  const auto& entry = *i->second;
+  converted.status = entry.status;
+  converted.diagnostics = entry.diagnostics;
+  converted.text = entry.text;
+  converted.stats = {};
+  return true;
+}
+
+void ResponseCache::insert(const string& request, const ConvertedGrammar& converted) {
+  lock_guard lock(m);
+  if(capacity == 0 || index.contains(request)) {
+    return;
+  }
+  entries.push_front({.request = request, .status = converted.status, .diagnostics = converted.diagnostics, .text = converted.text});
+  index.emplace(entries.front().request, entries.begin());
+  while(entries.size() > capacity) {
+    index.erase(entries.back().request);
+    entries.pop_back();
+  }
+}
+
+ConversionServer::ConversionServer(Options options): options(std::move(options)), cache(this->options.cacheSize) {
+}
+
+ConversionServer::~ConversionServer() {
+  if(auto fd = listenFd.exchange(-1); fd != -1) {
+    close(fd);
+    unlink(options.socketPath.c_str());
+  }
+}
+
+// a socket file left by a server that's gone is replaced, one that still answers is not
+bool ConversionServer::listen(string& error) {
+  sockaddr_un address;
+  if(!socketAddress(options.socketPath, address, error)) {
+    return false;
+  }
+
+  auto probe = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  auto answered = probe != -1 && connect(probe, reinterpret_cast<sockaddr*>(&address), sizeof address) == 0;
+  if(probe != -1) {
+    close(probe);
+  }
+  if(answered) {
+    error = "a server is already listening on \"" + options.socketPath + "\"";
+    return false;
+  }
+  unlink(options.socketPath.c_str());
+
+  auto fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if(fd == -1 || bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof address) == -1 || ::listen(fd, static_cast<int>(options.maxPending)) == -1) {
+    error = "can't listen on \"" + options.socketPath + "\": " + strerror(errno);
+    if(fd != -1) {
+      close(fd);
+    }
+    return false;
+  }
+  listenFd = fd;
+  return true;
+}
+
+void ConversionServer::run() {
+  vector<jthread> workers;
+  for(size_t i = 0; i < max(options.numWorkers, size_t{1}); ++i) {
+    workers.emplace_back([this] { worker(); });
+  }
+
+  while(!stopping) {
+    auto fd = accept4(listenFd, nullptr, nullptr, SOCK_CLOEXEC);
+    if(fd == -1) {
+      if(errno == EINTR || errno == ECONNABORTED) {
+        continue;
+      }
+      break;
+    }
+    ++numConnections;
+// stop can't notify from a signal handler so the wait for room checks for it now and then
+    unique_lock lock(m);
+    while(pending.size() >= options.maxPending && !stopping) {
+      roomReady.wait_for(lock, 100ms);
+    }
+    if(stopping) {
+      close(fd);
+      break;
+    }
+    pending.push_back(fd);
+    connectionReady.notify_one();
+  }
+
+// connections not yet taken are dropped, the ones being served finish their current request
+  {
+    lock_guard lock(m);
+    closed = true;
+    for(auto fd: pending) {
+      close(fd);
+    }
+    pending.clear();
+    for(auto fd: active) {
+      shutdown(fd, SHUT_RD);
+    }
+  }
+  connectionReady.notify_all();
+  workers.clear();
+}
+
+void ConversionServer::stop() {
+  stopping = true;
+  if(auto fd = listenFd.load(); fd != -1) {
+    shutdown(fd, SHUT_RDWR);
+  }
+}
+
+ConversionServer::Stats ConversionServer::stats() const {
+  return {.numConnections = numConnections, .numRequests = numRequests, .numCacheHits = numCacheHits, .numFailed = numFailed, .numRuleCacheHits = numRuleCacheHits, .numRuleCacheMisses = numRuleCacheMisses};
+}
+
+// a connection is added to active in the same step it's taken so run can always shut it down
+void ConversionServer::worker() {
+  Converter converter(true);
+  for(;;) {
+    int fd;
+    {
+      unique_lock lock(m);
+      connectionReady.wait(lock, [this] { return !pending.empty() || closed; });
+      if(pending.empty()) {
+        return;
+      }
+      fd = pending.front();
+      pending.pop_front();
+      active.insert(fd);
+    }
+    roomReady.notify_one();
+
+// a read that times out fails like one from a closed connection and ends serve
+    if(auto millis = options.idleTimeoutMillis; millis != 0) {
+      timeval timeout{.tv_sec = static_cast<time_t>(millis / 1000), .tv_usec = static_cast<suseconds_t>(millis % 1000 * 1000)};
+      setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof timeout);
+    }
+    serve(fd, converter);
+
+    {
+      lock_guard lock(m);
+      active.erase(fd);
+    }
+    close(fd);
+  }
+}
+
+void ConversionServer::serve(int fd, Converter& converter) {
+  string request;
+  ConvertedGrammar converted;
+  auto fail = [&converted](int status, string diagnostic) {
+    converted.status = status;
+    converted.text.clear();
+    converted.diagnostics.assign(1, std::move(diagnostic));
+  };
+  while(readFrame(fd, request)) {
+    ++numRequests;
+    auto cached = cache.find(request, converted);
+    if(cached) {
+      ++numCacheHits;
+    } else {
+      string_view input;
+      ConvertOptions requestOptions;
+      string error;
+      if(!decodeRequest(request, input, requestOptions, error, options.maxJobs, options.maxExpandThreads)) {
+        fail(1, std::move(error));
+      } else {
+// rule cache is the server's choice, it can't be used for streamed or pipelined requests
+        if(!requestOptions.stream && !requestOptions.pipeline) {
+          requestOptions.ruleCacheDir = options.ruleCacheDir;
+          requestOptions.keepRules = options.keepRules;
+        }
+        try {
+          converter.convert(input, requestOptions, converted);
+          numRuleCacheHits += converted.stats.numRuleCacheHits;
+          numRuleCacheMisses += converted.stats.numRuleCacheMisses;
+          cache.insert(request, converted);
+        } catch(const exception& e) {
+          fail(-1, e.what());
+        }
+      }
+    }
+    if(!converted) {
+      ++numFailed;
+    }
+    auto header = encodeResponseHeader(converted, cached);
+    if(!writeFrame(fd, {header, converted.text})) {
+      return;
+    }
+  }
+}
+
+ConversionClient::~ConversionClient() {
+  if(fd != -1) {
+    close(fd);
+  }
+}
+
+bool ConversionClient::connect(const string& socketPath, string& error) {
+  sockaddr_un address;
+  if(!socketAddress(socketPath, address, error)) {
+    return false;
+  }
+  if(fd != -1) {
+    close(fd);
+  }
+  fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if(fd == -1 || ::connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof address) == -1) {
+    error = "can't connect to \"" + socketPath + "\": " + strerror(errno);
+    if(fd != -1) {
+      close(fd);
+      fd = -1;
+    }
+    return false;
+  }
+  return true;
+}
+
+bool ConversionClient::convert(string_view input, const ConvertOptions& options, ConvertedGrammar& converted, bool* cached) {
+  bool wasCached;
+  if(fd == -1 || !writeFrame(fd, {encodeRequest(input, options)}) || !readFrame(fd, frame) || !decodeResponse(frame, converted, wasCached)) {
+    return false;
+  }
+  if(cached != nullptr) {
+    *cached = wasCached;
+  }
+  return true;
+}
+
+}
@@ -0,0 +1,208 @@
+#ifndef EBNFTOBISON_SERVER_H
+#define EBNFTOBISON_SERVER_H
+// ebnftobison_server.h
+
+/*
+MIT License
+
+Copyright (c) 2024 Zartaj Majeed
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <list>
+#include <mutex>
+#include <set>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "api/ebnftobison_api.h"
+
+namespace ebnftobison {
+using namespace std;
+
+// conversion service over a local unix socket so a build system that converts grammars all day pays for startup once
+//
+// every message either way is a frame, a 4 byte big-endian length and then that many bytes
+// a request is lines of "option value" with the names of the command line options, an empty line, then the grammar text
+// a response is a "status n" line, a "cached 0|1" line, a "diagnostic text" line for each diagnostic, an empty line, then the converted rules
+// a connection can carry any number of requests one after another, each answered before the next is read
+
+// largest frame accepted, anything longer is taken as garbage and the connection is dropped
+constexpr size_t maxFrameSize = size_t{1} << 30;
+
+string encodeRequest(string_view input, const ConvertOptions& options);
+
+// false with error set for an option that isn't known or has a bad value
+// jobs and expand-threads above maxJobs and maxExpandThreads are bad values too, a server limits them so no request can take all of its threads
+bool decodeRequest(string_view request, string_view& input, ConvertOptions& options, string& error, size_t maxJobs = SIZE_MAX, size_t maxExpandThreads = SIZE_MAX);
+
+// header of a response, the converted text follows it
+string encodeResponseHeader(const ConvertedGrammar& converted, bool cached);
+
+// false for a response that doesn't follow the format
+bool decodeResponse(string_view response, ConvertedGrammar& converted, bool& cached);
+
+// whole frame read into frame, false at end of input or on error
+bool readFrame(int fd, string& frame);
+
+// frame made of the parts one after another, written without copying them together
+bool writeFrame(int fd, const vector<string_view>& parts);
+
+// converted results of recent requests, most recently used kept
+// a request with the same options and text as one before is answered without converting again
+class ResponseCache {
+public:
+
+  explicit ResponseCache(size_t capacity): capacity(capacity) {}
+
+  bool find(const string& request, ConvertedGrammar& converted);
+
+  void insert(const string& request, const ConvertedGrammar& converted);
+
+private:
+
+  struct Entry {
+    string request;
+    int status;
+    vector<string> diagnostics;
+    string text;
+  };
+
+  mutex m;
+  size_t capacity;
+  list<Entry> entries;
+// keys are views of requests in entries
+  unordered_map<string_view, list<Entry>::iterator> index;
+
+};
+
+class ConversionServer {
+public:
+
+  struct Options {
+    string socketPath;
+// connections are served by this many threads, each with a Converter of its own
+    size_t numWorkers = 1;
+// accepted connections waiting for a worker, when full no more are accepted and new clients queue in the listen backlog
+    size_t maxPending = 64;
+// responses kept in the cache, 0 for no cache
+    size_t cacheSize = 64;
+// most jobs and expand threads a request may ask for, every worker can be running a request with this many
+    size_t maxJobs = 1;
+    size_t maxExpandThreads = 1;
+// converted rules are cached one by one under this directory, shared by the workers and by other servers using it, empty for none
+    string ruleCacheDir{};
+// each worker keeps the rules of its last conversion in memory, so a request changing a few rules of the grammar before converts only those
+    bool keepRules = false;
+// a client that sends nothing for this long is disconnected so it can't hold a worker, 0 to wait forever
+    size_t idleTimeoutMillis = 60000;
+  };
+
+  struct Stats {
+    uint64_t numConnections = 0;
+    uint64_t numRequests = 0;
+    uint64_t numCacheHits = 0;
+    uint64_t numFailed = 0;
+    uint64_t numRuleCacheHits = 0;
+    uint64_t numRuleCacheMisses = 0;
+  };
+
+  explicit ConversionServer(Options options);
+
+  ConversionServer(const ConversionServer&) = delete;
+  ConversionServer& operator=(const ConversionServer&) = delete;
+
+  ~ConversionServer();
+
+// makes the socket, false with error set when it can't or another server is already listening on it
+  bool listen(string& error);
+
+// accepts connections until stop is called, then waits for the workers to finish the requests they're on
+  void run();
+
+// only sets a flag and shuts the listening socket down so it can be called from a signal handler
+  void stop();
+
+  Stats stats() const;
+
+private:
+
+  void worker();
+
+// answers requests on fd until the client closes it, goes idle or the server stops
+  void serve(int fd, Converter& converter);
+
+  Options options;
+// atomic since stop reads them from a signal handler
+  atomic<int> listenFd{-1};
+  atomic<bool> stopping{false};
+
+  mutex m;
+  condition_variable connectionReady;
+  condition_variable roomReady;
+// guarded by m
+  deque<int> pending;
+  set<int> active;
+  bool closed = false;
+
+  ResponseCache cache;
+
+  atomic<uint64_t> numConnections{0};
+  atomic<uint64_t> numRequests{0};
+  atomic<uint64_t> numCacheHits{0};
+  atomic<uint64_t> numFailed{0};
+  atomic<uint64_t> numRuleCacheHits{0};
+  atomic<uint64_t> numRuleCacheMisses{0};
+
+};
+
+// client end of a connection to a ConversionServer
+class ConversionClient {
+public:
+
+  ConversionClient() = default;
+
+  ConversionClient(const ConversionClient&) = delete;
+  ConversionClient& operator=(const ConversionClient&) = delete;
+
+  ~ConversionClient();
+
+  bool connect(const string& socketPath, string& error);
+
+// sends one request and waits for its response, false when the connection failed
+  bool convert(string_view input, const ConvertOptions& options, ConvertedGrammar& converted, bool* cached = nullptr);
+
+private:
+
+  int fd = -1;
+  string frame;
+
+};
+
+}
+
+#endif
@@ -0,0 +1,232 @@
+// ebnftobison_snapshot.bench.cpp
+
+/*
+MIT License
+
+Copyright (c) 2024 Zartaj Majeed
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <cstdio>
+#include <cstdlib>
+#include <charconv>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include <algorithm>
+
+#include <getopt.h>
+#include <unistd.h>
+
+#include "api/ebnftobison_api.h"
+#include "api/ebnftobison_snapshot.h"
+#include "lexer/ebnftobison_mapped_file.h"
+
+using namespace std;
+using namespace ebnftobison;
+
+namespace {
+
+// load time of converted rules, read back from the bison text a tool has to tokenize and from a snapshot mapped with GrammarView
+// both end with rules a tool can look symbols up in, the walk adds touching every production of the snapshot
+
+// what a tool builds from the text, the same tables a snapshot already has
+struct TextGrammar {
+  unordered_map<string_view, uint32_t> symbolIds;
+  vector<string_view> symbolNames;
+  vector<uint32_t> ruleNames;
+  vector<uint64_t> ruleProductions{0};
+  vector<uint64_t> productionSymbols{0};
+  vector<uint32_t> symbols;
+
+  uint32_t intern(string_view name) {
+    auto [i, added] = symbolIds.try_emplace(name, symbolNames.size());
+    if(added) {
+      symbolNames.push_back(name);
+    }
+    return i->second;
+  }
+};
+
+// text is "# n productions", "rule:", n production lines and an empty line for each rule
+// the count is needed since an empty first production is an empty line, the first production is "  a  b" and the rest "|  a  b"
+size_t parseText(string_view text, TextGrammar& grammar) {
+  size_t i = 0;
+  auto nextLine = [&text, &i] {
+    auto lineEnd = min(text.find('\n', i), text.size());
+    auto line = text.substr(i, lineEnd - i);
+    i = lineEnd + 1;
+    return line;
+  };
+  while(i < text.size()) {
+    auto line = nextLine();
+    uint64_t numProductions = 0;
+    if(!line.starts_with("# ") || from_chars(line.data() + 2, line.data() + line.size(), numProductions).ec != errc{}) {
+      continue;
+    }
+    line = nextLine();
+    grammar.ruleNames.push_back(grammar.intern(line.substr(0, line.size() - 1)));
+    for(; numProductions > 0; --numProductions) {
+      line = nextLine();
+      for(size_t j = line.starts_with('|')? 1: 0; j < line.size();) {
+        j = line.find_first_not_of(' ', j);
+        if(j == string_view::npos) {
+          break;
+        }
+        auto end = min(line.find(' ', j), line.size());
+        grammar.symbols.push_back(grammar.intern(line.substr(j, end - j)));
+        j = end;
+      }
+      grammar.productionSymbols.push_back(grammar.symbols.size());
+    }
+    grammar.ruleProductions.push_back(grammar.productionSymbols.size() - 1);
+  }
+  return grammar.ruleNames.size();
+}
+
+uint64_t walk(const GrammarView& view) {
+  uint64_t sum = 0;
+  for(size_t rule = 0; rule < view.numRules(); ++rule) {
+    for(size_t k = 0; k < view.numProductions(rule); ++k) {
+      for(auto symbol: view.production(rule, k)) {
+        sum += symbol;
+      }
+    }
+  }
+  return sum;
+}
+
+template<typename F>
+void run(const char* name, int iterations, F loadOnce) {
+  vector<double> secs;
+  auto failed = false;
+  for(int i = 0; i < iterations; ++i) {
+    auto startTime = chrono::steady_clock::now();
+    failed |= !loadOnce();
+    auto endTime = chrono::steady_clock::now();
+    secs.push_back(chrono::duration<double>(endTime - startTime).count());
+  }
+  ranges::sort(secs);
+  double total = 0;
+  for(auto s: secs) {
+    total += s;
+  }
+  printf("%-14s mean %.6f secs, median %.6f secs, min %.6f secs, max %.6f secs%s\n", name, total / secs.size(), secs[secs.size() / 2], secs.front(), secs.back(), failed? " (load failed)": "");
+}
+
+void usage() {
+  puts("usage: ebnftobison_snapshot.bench [-i iterations] [-f n] [grammar_file]");
+  puts("convert grammar_file once, write its text and snapshot to temporary files and report the time to load each of them");
+  puts("text: map and tokenize the bison text into symbol and production tables, snapshot: map and check a snapshot with GrammarView, snapshot+walk: also visit every symbol of every production");
+  puts("-i, --iterations: number of loads of each kind, default 20");
+  puts("-f, --factor-threshold: factor threshold of the conversion, default 0");
+  puts("grammar_file: defaults to docs/gqlgrammar.quotedliterals.txt");
+  puts("-h, --help: print this help");
+}
+
+}
+
+int main(int argc, char* argv[]) {
+
+  int iterations = 20;
+  ConvertOptions options;
+  string inputFile = EBNFTOBISON_DOCS_DIR "/gqlgrammar.quotedliterals.txt";
+
+  option longOptions[] = {
+    {"iterations", required_argument, nullptr, 'i'},
+    {"factor-threshold", required_argument, nullptr, 'f'},
+    {"help", no_argument, nullptr, 'h'},
+    {}
+  };
+
+  for(int opt; (opt = getopt_long(argc, argv, "i:f:h", longOptions, nullptr)) != -1;) {
+    switch(opt) {
+    case 'i':
+      iterations = atoi(optarg);
+      break;
+    case 'f':
+      options.factorThreshold = strtoull(optarg, nullptr, 10);
+      break;
+    case 'h':
+      usage();
+      exit(0);
+    default:
+      usage();
+      exit(1);
+    }
+  }
+
+  if(optind < argc) {
+    inputFile = argv[optind];
+  }
+
+  if(iterations < 1) {
+    fprintf(stderr, "iterations must be at least 1\n");
+    exit(1);
+  }
+
+  MappedFile mappedFile;
+  if(!mappedFile.open(inputFile)) {
+    fprintf(stderr, "could not map %s\n", inputFile.c_str());
+    exit(1);
+  }
+
+  Converter converter;
+  ConvertedGrammar converted;
+  converter.convert(mappedFile.contents(), options, converted);
+  string snapshot;
+  if(!converted || !converter.printSnapshot(snapshot)) {
+    fprintf(stderr, "conversion of %s failed\n", inputFile.c_str());
+    exit(1);
+  }
+
+  auto dir = filesystem::temp_directory_path();
+  auto textFile = (dir / ("ebnftobison_snapshot_bench_" + to_string(getpid()) + ".y")).string();
+  auto snapshotFile = (dir / ("ebnftobison_snapshot_bench_" + to_string(getpid()) + ".snapshot")).string();
+  ofstream(textFile) << converted.text;
+  ofstream(snapshotFile) << snapshot;
+
+  printf("%s: %lu rules, %lu productions, text %zu bytes, snapshot %zu bytes, %d iterations\n", inputFile.c_str(), converted.stats.numRulesGenerated, converted.stats.numProductionsGenerated, converted.text.size(), snapshot.size(), iterations);
+
+  run("text", iterations, [&] {
+    MappedFile file;
+    TextGrammar grammar;
+    return file.open(textFile) && parseText(file.contents(), grammar) == converted.stats.numRulesGenerated;
+  });
+
+  run("snapshot", iterations, [&] {
+    GrammarView view;
+    string error;
+    return view.open(snapshotFile, error) && view.numRules() == converted.stats.numRulesGenerated;
+  });
+
+  run("snapshot+walk", iterations, [&] {
+    GrammarView view;
+    string error;
+    return view.open(snapshotFile, error) && walk(view) > 0;
+  });
+
+  filesystem::remove(textFile);
+  filesystem::remove(snapshotFile);
+}
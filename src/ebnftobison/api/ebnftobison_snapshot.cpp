@@ -0,0 +1,112 @@
+// ebnftobison_snapshot.cpp
+
+/*
+MIT License
+
+Copyright (c) 2024 Zartaj Majeed
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <algorithm>
+#include <cstring>
+
+#include "api/ebnftobison_snapshot.h"
+
+namespace ebnftobison {
+
+bool GrammarView::open(const string& filename, string& error) {
+  if(!file.open(filename)) {
+    error = "error opening file \""s + filename + "\"";
+    return false;
+  }
+  if(!assign(file.contents(), error)) {
+    error = filename + ": " + error;
+    return false;
+  }
+  return true;
+}
+
+// only the header and the ends of the offset arrays are looked at, nothing that grows with the grammar
+bool GrammarView::assign(string_view data, string& error) {
+  header = nullptr;
+  if(data.size() < sizeof(SnapshotHeader) || reinterpret_cast<uintptr_t>(data.data()) % 8 != 0) {
+    error = "not a snapshot";
+    return false;
+  }
+  auto h = reinterpret_cast<const SnapshotHeader*>(data.data());
+  if(memcmp(h->magic, SnapshotHeader::expectedMagic, sizeof h->magic) != 0) {
+    error = "not a snapshot";
+    return false;
+  }
+  if(h->byteOrder != SnapshotHeader::expectedByteOrder) {
+    error = "snapshot has the wrong byte order";
+    return false;
+  }
+  if(h->version != SnapshotHeader::currentVersion) {
+    error = "snapshot version " + to_string(h->version) + " isn't " + to_string(SnapshotHeader::currentVersion);
+    return false;
+  }
+  if(h->fileSize != data.size()) {
+    error = "snapshot is truncated";
+    return false;
+  }
+
+// counts are compared against what fits without adding to or multiplying them so a huge count can't wrap around
+// offset arrays have an extra entry after count for the end of the last item
+  auto inside = [&data](uint64_t offset, uint64_t count, size_t size, uint64_t extra) {
+    if(offset % 8 != 0 || offset > data.size()) {
+      return false;
+    }
+    auto fits = (data.size() - offset) / size;
+    return extra <= fits && count <= fits - extra;
+  };
+  if(!inside(h->nameOffsets, h->numSymbols, sizeof(uint64_t), 1) ||
+    !inside(h->ruleProductions, h->numRules, sizeof(uint64_t), 1) ||
+    !inside(h->productionSymbols, h->numProductions, sizeof(uint64_t), 1) ||
+    !inside(h->ruleNames, h->numRules, sizeof(uint32_t), 0) ||
+    !inside(h->symbols, h->numProductionSymbols, sizeof(uint32_t), 0) ||
+    !inside(h->names, h->nameBytes, 1, 0)) {
+    error = "snapshot section out of range";
+    return false;
+  }
+
+  auto base = data.data();
+  nameOffsets = reinterpret_cast<const uint64_t*>(base + h->nameOffsets);
+  ruleProductions = reinterpret_cast<const uint64_t*>(base + h->ruleProductions);
+  productionSymbols = reinterpret_cast<const uint64_t*>(base + h->productionSymbols);
+  ruleNames = reinterpret_cast<const uint32_t*>(base + h->ruleNames);
+  symbols = reinterpret_cast<const uint32_t*>(base + h->symbols);
+  names = base + h->names;
+  if(nameOffsets[h->numSymbols] != h->nameBytes || ruleProductions[h->numRules] != h->numProductions || productionSymbols[h->numProductions] != h->numProductionSymbols) {
+    error = "snapshot sections don't match";
+    return false;
+  }
+  header = h;
+  return true;
+}
+
+size_t GrammarView::findRule(string_view name) const {
+  auto first = ruleNames;
+  auto last = ruleNames + numRules();
+  auto i = lower_bound(first, last, name, [this](uint32_t rule, string_view name) { return symbolName(rule) < name; });
+  return i != last && symbolName(*i) == name? i - first: numRules();
+}
+
+}
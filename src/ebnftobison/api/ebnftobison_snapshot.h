@@ -0,0 +1,134 @@
+#ifndef EBNFTOBISON_SNAPSHOT_H
+#define EBNFTOBISON_SNAPSHOT_H
+// ebnftobison_snapshot.h
+
+/*
+MIT License
+
+Copyright (c) 2024 Zartaj Majeed
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+
+#include "lexer/ebnftobison_mapped_file.h"
+
+// binary snapshot of converted rules that tools load with one mmap instead of reading and tokenizing the bison text
+// only standard headers are included here so a tool reading snapshots doesn't need the parser or its generated headers
+
+namespace ebnftobison {
+using namespace std;
+
+// a snapshot file is this header followed by its sections, every section starts at a multiple of 8 bytes
+// numbers are in the byte order of the machine that wrote them, a reader on a machine of the other order rejects the file
+// rules and their productions are in the order ebnftobison prints them, symbols are numbered in order of first use
+struct SnapshotHeader {
+  static constexpr char expectedMagic[8] = {'E', 'B', 'N', 'F', 'S', 'N', 'A', 'P'};
+// bumped whenever the layout changes
+  static constexpr uint32_t currentVersion = 1;
+  static constexpr uint32_t expectedByteOrder = 0x01020304;
+
+  char magic[8];
+  uint32_t version;
+  uint32_t byteOrder;
+  uint64_t fileSize;
+  uint64_t numSymbols;
+  uint64_t numRules;
+  uint64_t numProductions;
+  uint64_t numProductionSymbols;
+  uint64_t nameBytes;
+// file offsets of the sections
+// uint64_t[numSymbols + 1], symbol k's name starts at names + nameOffsets[k] and is NUL terminated
+  uint64_t nameOffsets;
+// uint64_t[numRules + 1], productions of rule k are ruleProductions[k] up to ruleProductions[k + 1]
+  uint64_t ruleProductions;
+// uint64_t[numProductions + 1], symbols of production k are productionSymbols[k] up to productionSymbols[k + 1]
+  uint64_t productionSymbols;
+// uint32_t[numRules], symbol of each rule
+  uint64_t ruleNames;
+// uint32_t[numProductionSymbols], symbols of every production one after another
+  uint64_t symbols;
+// char[nameBytes]
+  uint64_t names;
+};
+
+// read-only view of a snapshot, nothing is copied or parsed when it's opened
+// open checks the header and that every section lies inside the file, the contents of sections are trusted
+// so a snapshot should come from ebnftobison --snapshot or Converter::printSnapshot
+class GrammarView {
+public:
+
+  GrammarView() = default;
+
+  GrammarView(const GrammarView&) = delete;
+  GrammarView& operator=(const GrammarView&) = delete;
+
+// maps filename, false with error set when it isn't a snapshot this reader can use
+  bool open(const string& filename, string& error);
+
+// snapshot already in memory, data has to be 8 byte aligned and stay valid while the view is used
+  bool assign(string_view data, string& error);
+
+  size_t numSymbols() const { return header->numSymbols; }
+
+  string_view symbolName(uint32_t symbol) const {
+    auto start = nameOffsets[symbol];
+    return {names + start, nameOffsets[symbol + 1] - start - 1};
+  }
+
+// rules are in name order
+  size_t numRules() const { return header->numRules; }
+
+  uint32_t ruleName(size_t rule) const { return ruleNames[rule]; }
+
+  size_t numProductions(size_t rule) const { return ruleProductions[rule + 1] - ruleProductions[rule]; }
+
+// symbols of the k-th production of rule
+  span<const uint32_t> production(size_t rule, size_t k) const {
+    auto p = ruleProductions[rule] + k;
+    return {symbols + productionSymbols[p], symbols + productionSymbols[p + 1]};
+  }
+
+// productions of all rules together
+  size_t totalProductions() const { return header->numProductions; }
+
+// index of the rule named name by binary search, numRules() when there is none
+  size_t findRule(string_view name) const;
+
+private:
+
+  MappedFile file;
+  const SnapshotHeader* header = nullptr;
+  const uint64_t* nameOffsets = nullptr;
+  const uint64_t* ruleProductions = nullptr;
+  const uint64_t* productionSymbols = nullptr;
+  const uint32_t* ruleNames = nullptr;
+  const uint32_t* symbols = nullptr;
+  const char* names = nullptr;
+
+};
+
+}
+
+#endif
@@ -0,0 +1,168 @@
+// ebnftobison_watch.cpp
+
+/*
+MIT License
+
+Copyright (c) 2024 Zartaj Majeed
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+#include "api/ebnftobison_batch.h"
+#include "api/ebnftobison_watch.h"
+
+namespace ebnftobison {
+
+GrammarWatcher::GrammarWatcher(string input, string output, const ConvertOptions& options): input(std::move(input)), output(std::move(output)), options(options) {
+  this->options.keepRules = true;
+  this->options.inputName = this->input;
+  inputName = filesystem::path(this->input).filename().string();
+}
+
+GrammarWatcher::~GrammarWatcher() {
+  for(auto fd: {inotifyFd, wakeFds[0], wakeFds[1]}) {
+    if(fd != -1) {
+      close(fd);
+    }
+  }
+}
+
+bool GrammarWatcher::watch(string& error) {
+  auto dir = filesystem::path(input).parent_path();
+  if(dir.empty()) {
+    dir = ".";
+  }
+  inotifyFd = inotify_init1(IN_CLOEXEC);
+  if(inotifyFd == -1 || pipe2(wakeFds, O_CLOEXEC | O_NONBLOCK) == -1) {
+    error = "inotify: "s + strerror(errno);
+    return false;
+  }
+// a save is the end of a write or a file renamed onto the name, other events are ignored
+  if(inotify_add_watch(inotifyFd, dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) == -1) {
+    error = "error watching \""s + dir.string() + "\": " + strerror(errno);
+    return false;
+  }
+  return true;
+}
+
+GrammarWatcher::Event GrammarWatcher::convert() {
+  auto startTime = steady_clock::now();
+  Event event;
+
+// an editor can leave the file missing for a moment while it saves, that is a failed conversion and the next save fixes it
+// the file is read rather than mapped since an editor saving in place truncates it under a mapping
+  if(ifstream inputStream(input); inputStream) {
+    string text(istreambuf_iterator<char>(inputStream), {});
+    converter.parse(text, options, converted);
+  } else {
+    converted.status = 1;
+    converted.diagnostics.assign({"error opening file \""s + input + "\""});
+    converted.stats = {};
+  }
+  auto convertEndTime = steady_clock::now();
+  event.convertTime = convertEndTime - startTime;
+
+  if(converted) {
+    auto temporary = temporaryName(output);
+    auto out = fopen(temporary.c_str(), "w");
+    auto written = out != nullptr;
+    if(out != nullptr) {
+      converter.print([out, &written](string_view text) {
+        written = written && fwrite(text.data(), 1, text.size(), out) == text.size();
+      });
+      written = fclose(out) == 0 && written;
+    }
+    if(!written || rename(temporary.c_str(), output.c_str()) != 0) {
+      remove(temporary.c_str());
+      converted.status = 1;
+      converted.diagnostics.push_back("error writing file \""s + output + "\"");
+    }
+  }
+  event.writeTime = steady_clock::now() - convertEndTime;
+
+  event.status = converted.status;
+  event.diagnostics = converted.diagnostics;
+  event.numRules = converted.stats.numRuleCacheHits + converted.stats.numRuleCacheMisses;
+  event.numRulesConverted = converted.stats.numRuleCacheMisses;
+  event.totalTime = steady_clock::now() - startTime;
+  return event;
+}
+
+bool GrammarWatcher::waitForSave() {
+// events are read until a read has a save of input, several saves read together are one conversion
+  alignas(inotify_event) char buf[16 * 1024];
+  for(;;) {
+    pollfd fds[] = {{.fd = inotifyFd, .events = POLLIN, .revents = 0}, {.fd = wakeFds[0], .events = POLLIN, .revents = 0}};
+    if(poll(fds, 2, -1) == -1 && errno != EINTR) {
+      return false;
+    }
+    if(stopping) {
+      return false;
+    }
+    if(!(fds[0].revents & POLLIN)) {
+      continue;
+    }
+    auto n = read(inotifyFd, buf, sizeof buf);
+    if(n <= 0) {
+      if(n == -1 && errno == EINTR) {
+        continue;
+      }
+      return false;
+    }
+    auto saved = false;
+    for(ssize_t i = 0; i < n;) {
+      auto event = reinterpret_cast<const inotify_event*>(buf + i);
+      if(event->len > 0 && event->name == inputName) {
+        saved = true;
+      }
+      i += sizeof(inotify_event) + event->len;
+    }
+    if(saved) {
+      return true;
+    }
+  }
+}
+
+void GrammarWatcher::run(const Report& report) {
+  report(convert());
+  while(waitForSave()) {
+    report(convert());
+  }
+}
+
+void GrammarWatcher::stop() {
+  stopping = true;
+  if(wakeFds[1] != -1) {
+    char c = 0;
+    [[maybe_unused]] auto n = write(wakeFds[1], &c, 1);
+  }
+}
+
+}
@@ -0,0 +1,106 @@
+#ifndef EBNFTOBISON_WATCH_H
+#define EBNFTOBISON_WATCH_H
+// ebnftobison_watch.h
+
+/*
+MIT License
+
+Copyright (c) 2024 Zartaj Majeed
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "api/ebnftobison_api.h"
+
+namespace ebnftobison {
+using namespace std;
+using namespace chrono;
+
+// converts a grammar file again every time it's saved and rewrites its output
+// the Converter keeps the rules of the last conversion so a save only parses the rules that changed
+// saves are seen with inotify on the file's directory, which catches editors that write a new file and rename it over the old one
+class GrammarWatcher {
+public:
+
+// one conversion and what it took
+  struct Event {
+// 0 on success like the parser
+    int status = 0;
+    vector<string> diagnostics;
+    uint64_t numRules = 0;
+// rules that weren't kept from the conversion before
+    uint64_t numRulesConverted = 0;
+// reading and converting input
+    duration<double> convertTime{};
+// printing rules and renaming them over the output
+    duration<double> writeTime{};
+// from the save being read from inotify to the output being in place
+    duration<double> totalTime{};
+  };
+
+  using Report = function<void(const Event&)>;
+
+// options.keepRules is always set, options.inputName is replaced by input
+  GrammarWatcher(string input, string output, const ConvertOptions& options);
+
+  GrammarWatcher(const GrammarWatcher&) = delete;
+  GrammarWatcher& operator=(const GrammarWatcher&) = delete;
+
+  ~GrammarWatcher();
+
+// starts watching, false with error set when input's directory can't be watched
+  bool watch(string& error);
+
+// converts input and writes output once, a failed conversion leaves the output as it was
+  Event convert();
+
+// converts once and then after every save of input until stop is called, report is called after each conversion
+  void run(const Report& report);
+
+// only sets a flag and writes to a pipe so it can be called from a signal handler
+  void stop();
+
+private:
+
+// true when events read from the inotify descriptor include a save of input, false once stopped
+  bool waitForSave();
+
+  string input;
+  string output;
+// name of input in its directory that events are matched against
+  string inputName;
+  ConvertOptions options;
+  Converter converter;
+  ConvertedGrammar converted;
+  int inotifyFd = -1;
+  int wakeFds[2] = {-1, -1};
+  atomic<bool> stopping{false};
+
+};
+
+}
+
+#endif
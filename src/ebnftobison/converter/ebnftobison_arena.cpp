@@ -0,0 +1,51 @@
+// ebnftobison_arena.cpp
+
+/*
+MIT License
+
+Copyright (c) 2024 Zartaj Majeed
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "converter/ebnftobison_arena.h"
+
+namespace ebnftobison {
+
+void* CountingResource::do_allocate(size_t bytes, size_t alignment) {
+  ++numAllocations;
+  bytesAllocated += bytes;
+  return upstream->allocate(bytes, alignment);
+}
+
+void CountingResource::do_deallocate(void* p, size_t bytes, size_t alignment) {
+  upstream->deallocate(p, bytes, alignment);
+}
+
+bool CountingResource::do_is_equal(const pmr::memory_resource& other) const noexcept {
+  return this == &other;
+}
+
+void Arena::release() {
+  arena.release();
+  requests.numAllocations = requests.bytesAllocated = 0;
+  chunks.numAllocations = chunks.bytesAllocated = 0;
+}
+
+}
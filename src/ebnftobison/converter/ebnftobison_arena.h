@@ -0,0 +1,86 @@
+#ifndef EBNFTOBISON_ARENA_H
+#define EBNFTOBISON_ARENA_H
+// ebnftobison_arena.h
+
+/*
+MIT License
+
+Copyright (c) 2024 Zartaj Majeed
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+
+namespace ebnftobison {
+using namespace std;
+
+// memory resource that counts what is allocated through it and passes every call on to upstream
+class CountingResource: public pmr::memory_resource {
+public:
+
+  explicit CountingResource(pmr::memory_resource* upstream): upstream(upstream) {}
+
+  uint64_t numAllocations = 0;
+  uint64_t bytesAllocated = 0;
+
+private:
+
+  void* do_allocate(size_t bytes, size_t alignment) override;
+  void do_deallocate(void* p, size_t bytes, size_t alignment) override;
+  bool do_is_equal(const pmr::memory_resource& other) const noexcept override;
+
+  pmr::memory_resource* upstream;
+
+};
+
+// monotonic arena for the containers of one conversion, freed all at once when the arena goes away
+// allocations are counted on their way into the arena and the chunks it takes from the heap on their way out
+// so the difference is the number of heap allocations the arena saved
+class Arena {
+public:
+
+  Arena(): chunks(pmr::new_delete_resource()), arena(&chunks), requests(&arena) {}
+
+  Arena(const Arena&) = delete;
+  Arena& operator=(const Arena&) = delete;
+
+  pmr::memory_resource* resource() { return &requests; }
+
+  uint64_t numAllocations() const { return requests.numAllocations; }
+  uint64_t bytesAllocated() const { return requests.bytesAllocated; }
+  uint64_t numChunks() const { return chunks.numAllocations; }
+  uint64_t chunkBytes() const { return chunks.bytesAllocated; }
+
+// frees all chunks and starts counting over, nothing allocated from the arena may be used after this
+  void release();
+
+private:
+
+  CountingResource chunks;
+  pmr::monotonic_buffer_resource arena;
+  CountingResource requests;
+
+};
+
+}
+
+#endif
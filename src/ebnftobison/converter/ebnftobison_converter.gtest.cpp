@@ -0,0 +1,402 @@
+// ebnftobison_converter.gtest.cpp
+
+/*
+MIT License
+
+Copyright (c) 2024 Zartaj Majeed
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <limits>
+#include <atomic>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include "converter/ebnftobison_symbol_table.h"
+#include "converter/ebnftobison_name_normalizer.h"
+#include "converter/ebnftobison_sequence_store.h"
+#include "converter/ebnftobison_expr.h"
+#include "converter/ebnftobison_expander.h"
+#include "converter/ebnftobison_enumerator.h"
+#include "converter/ebnftobison_arena.h"
+#include "converter/ebnftobison_task_pool.h"
+
+using namespace std;
+
+using namespace ::testing;
+
+namespace ebnftobison::testing {
+
+TEST(SymbolTable, test_0) {
+
+  SymbolTable symbols;
+
+  auto a = symbols.intern("session_activity");
+  auto b = symbols.intern("SESSION");
+  auto c = symbols.intern("\"|+|\"");
+
+  EXPECT_EQ(symbols.size(), 3);
+  EXPECT_EQ(symbols.intern("SESSION"), b);
+  EXPECT_EQ(symbols.size(), 3);
+  EXPECT_NE(a, b);
+  EXPECT_NE(b, c);
+  EXPECT_EQ(symbols.name(a), "session_activity");
+  EXPECT_EQ(symbols.name(c), "\"|+|\"");
+  EXPECT_THAT(symbols.names({c, a, c}), ElementsAre("\"|+|\"", "session_activity", "\"|+|\""));
+}
+
+TEST(SymbolTable, test_1) {
+
+  SymbolTable symbols;
+
+// ids are handed out in insertion order, not name order
+  auto z = symbols.intern("z");
+  auto b = symbols.intern("b");
+  auto a = symbols.intern("a");
+
+  EXPECT_TRUE(symbols.less({a}, {z}));
+  EXPECT_FALSE(symbols.less({z}, {a}));
+  EXPECT_TRUE(symbols.less({b}, {b, a}));
+  EXPECT_FALSE(symbols.less({b, a}, {b}));
+  EXPECT_TRUE(symbols.less({b, a, z}, {b, z}));
+  EXPECT_FALSE(symbols.less({a, b}, {a, b}));
+  EXPECT_TRUE(symbols.less({}, {a}));
+  EXPECT_THAT(symbols.nameRanks(), ElementsAre(2, 1, 0));
+}
+
+TEST(NameNormalizer, test_0) {
+
+  NameNormalizer normalize;
+
+  EXPECT_EQ(normalize("<true literal>"), "true_literal");
+  EXPECT_EQ(normalize("<GQL-program>"), "GQL_program");
+  EXPECT_EQ(normalize("<transaction mode 1>"), "transaction_mode_1");
+  EXPECT_EQ(normalize("<solidus/reverse_solidus>"), "solidus_reverse_solidus");
+  EXPECT_EQ(normalize("<caf\xc3\xa9>"), "caf__");
+}
+
+TEST(NameNormalizer, test_1) {
+
+  NameNormalizer normalize;
+
+  const auto& first = normalize("<session activity>");
+  const auto& second = normalize("<session activity>");
+
+// same nonterminal is normalized once and gives back the same cached name
+  EXPECT_EQ(&first, &second);
+  EXPECT_EQ(normalize.size(), 1);
+
+  normalize("<session set command>");
+  EXPECT_EQ(normalize.size(), 2);
+}
+
+TEST(SequenceStore, test_0) {
+
+  SequenceStore sequences;
+
+  auto ab = sequences.intern({0, 1});
+  auto abc = sequences.intern({0, 1, 2});
+  auto cd = sequences.intern({2, 3});
+
+// equal sequences get the same id however they are built
+  EXPECT_EQ(sequences.intern({0, 1}), ab);
+  EXPECT_EQ(sequences.append(ab, 2), abc);
+  EXPECT_EQ(sequences.concatenate(ab, sequences.intern({2})), abc);
+  EXPECT_EQ(sequences.concatenate(SequenceStore::emptySequence, cd), cd);
+  EXPECT_EQ(sequences.concatenate(cd, SequenceStore::emptySequence), cd);
+  EXPECT_EQ(sequences.intern({}), SequenceStore::emptySequence);
+
+  EXPECT_THAT(sequences.symbols(abc), ElementsAre(0, 1, 2));
+  EXPECT_THAT(sequences.symbols(sequences.concatenate(abc, cd)), ElementsAre(0, 1, 2, 2, 3));
+  EXPECT_TRUE(sequences.symbols(SequenceStore::emptySequence).empty());
+
+// empty sequence, 4 single symbols, joins ab, abc, cd and abccd, a join adds one node however long its parts are
+  EXPECT_EQ(sequences.size(), 9);
+}
+
+TEST(SequenceStore, test_1) {
+
+  SequenceStore sequences;
+  vector<uint32_t> symbolRanks{3, 2, 1, 0};
+
+// (a b) c and a (b c) are the same sequence
+  auto a = sequences.intern({0});
+  auto bc = sequences.intern({1, 2});
+  auto abc = sequences.concatenate(a, bc);
+  EXPECT_EQ(abc, sequences.intern({0, 1, 2}));
+  EXPECT_EQ(sequences.length(abc), 3);
+
+// ranks put symbol 3 first and symbol 0 last
+  FlatProductions flatProductions(sequences);
+  flatProductions.assign(sequences.internProduction({ {0, 1}, {0, 1, 2}, {0}, {0, 2}, {3}, {} }));
+  flatProductions.sort(symbolRanks);
+  ASSERT_EQ(flatProductions.size(), 6);
+  EXPECT_THAT(flatProductions[0], ElementsAre());
+  EXPECT_THAT(flatProductions[1], ElementsAre(3));
+  EXPECT_THAT(flatProductions[2], ElementsAre(0));
+  EXPECT_THAT(flatProductions[3], ElementsAre(0, 2));
+  EXPECT_THAT(flatProductions[4], ElementsAre(0, 1));
+  EXPECT_THAT(flatProductions[5], ElementsAre(0, 1, 2));
+
+// buffers are reused for the next production
+  flatProductions.assign(sequences.internProduction({ {2, 2} }));
+  flatProductions.sort(symbolRanks);
+  ASSERT_EQ(flatProductions.size(), 1);
+  EXPECT_THAT(flatProductions[0], ElementsAre(2, 2));
+}
+
+TEST(SequenceStore, test_2) {
+
+  SequenceStore sequences;
+
+// enough sequences to grow the index several times
+  vector<SequenceId> ids;
+  for(SymbolId i = 0; i < 5000; ++i) {
+    ids.push_back(sequences.intern({i % 7, i}));
+  }
+  for(SymbolId i = 0; i < 5000; ++i) {
+    EXPECT_EQ(sequences.intern({i % 7, i}), ids[i]);
+    EXPECT_THAT(sequences.symbols(ids[i]), ElementsAre(i % 7, i));
+  }
+// single symbols 0 to 4999 and one join for each sequence
+  EXPECT_EQ(sequences.size(), 1 + 5000 + 5000);
+
+  auto production = sequences.internProduction({ {1}, {}, {1}, {0, 1} });
+  EXPECT_EQ(production.size(), 3);
+  EXPECT_EQ(production.front(), SequenceStore::emptySequence);
+  EXPECT_TRUE(ranges::is_sorted(production));
+
+// first of each id stays where it was
+  auto a = sequences.intern({0});
+  auto b = sequences.intern({1});
+  Production repeated{b, a, b, SequenceStore::emptySequence, a};
+  sequences.removeDuplicates(repeated);
+  EXPECT_THAT(repeated, ElementsAre(b, a, SequenceStore::emptySequence));
+
+  sequences.clear();
+  EXPECT_EQ(sequences.size(), 1);
+}
+
+TEST(Expr, test_0) {
+
+// a [b] {c | d e}
+  Expr expr{.kind = Expr::Kind::sequence, .children = {
+    {.kind = Expr::Kind::symbol, .symbol = 0},
+    {.kind = Expr::Kind::optional, .children = {
+      {.kind = Expr::Kind::symbol, .symbol = 1},
+    }},
+    {.kind = Expr::Kind::choice, .children = {
+      {.kind = Expr::Kind::symbol, .symbol = 2},
+      {.kind = Expr::Kind::sequence, .children = {
+        {.kind = Expr::Kind::symbol, .symbol = 3},
+        {.kind = Expr::Kind::symbol, .symbol = 4},
+      }},
+    }},
+  }};
+
+// a b c, a b d e, a c, a d e
+  auto size = predictSize(expr);
+  EXPECT_EQ(size.numProductions, 4);
+  EXPECT_EQ(size.numSymbols, 12);
+  EXPECT_EQ(size.numListProductions, 0);
+
+// {a b | c}... becomes a choice group rule of 2 productions and its list rule of 2 more
+  Expr repetition{.kind = Expr::Kind::repetition, .children = {
+    {.kind = Expr::Kind::choice, .children = {
+      {.kind = Expr::Kind::sequence, .children = {
+        {.kind = Expr::Kind::symbol, .symbol = 0},
+        {.kind = Expr::Kind::symbol, .symbol = 1},
+      }},
+      {.kind = Expr::Kind::symbol, .symbol = 2},
+    }},
+  }};
+  size = predictSize(repetition);
+  EXPECT_EQ(size.numProductions, 1);
+  EXPECT_EQ(size.numSymbols, 1);
+  EXPECT_EQ(size.numListProductions, 4);
+}
+
+TEST(Expr, test_1) {
+
+// 70 optionals in a row overflow 64 bits
+  Expr expr{.kind = Expr::Kind::sequence};
+  for(SymbolId i = 0; i < 70; ++i) {
+    expr.children.push_back({.kind = Expr::Kind::optional, .children = { {.kind = Expr::Kind::symbol, .symbol = i} }});
+  }
+
+  auto size = predictSize(expr);
+  EXPECT_EQ(size.numProductions, numeric_limits<uint64_t>::max());
+  EXPECT_EQ(size.numSymbols, numeric_limits<uint64_t>::max());
+}
+
+TEST(Expander, test_0) {
+
+// a [b] [c]
+  Expr expr{.kind = Expr::Kind::sequence, .children = {
+    {.kind = Expr::Kind::symbol, .symbol = 0},
+    {.kind = Expr::Kind::optional, .children = { {.kind = Expr::Kind::symbol, .symbol = 1} }},
+    {.kind = Expr::Kind::optional, .children = { {.kind = Expr::Kind::symbol, .symbol = 2} }},
+  }};
+
+  SequenceStore sequences;
+
+  vector<Production> factored;
+  auto factor = [&factored](Production&& production) {
+    factored.push_back(std::move(production));
+    return static_cast<SymbolId>(100 + factored.size() - 1);
+  };
+  auto repeat = [](const Expr&, Production&& production) {
+    return std::move(production);
+  };
+
+  Expander distribute(sequences, 0, factor, repeat);
+  EXPECT_THAT(distribute(expr), UnorderedElementsAreArray(sequences.internProduction({ {0}, {0, 1}, {0, 1, 2}, {0, 2} })));
+  EXPECT_TRUE(factored.empty());
+
+// [c] would double 2 productions to 4
+  Expander expander(sequences, 3, factor, repeat);
+  EXPECT_THAT(expander(expr), UnorderedElementsAreArray(sequences.internProduction({ {0, 100}, {0, 1, 100} })));
+  ASSERT_EQ(factored.size(), 1);
+  EXPECT_THAT(factored.front(), UnorderedElementsAreArray(sequences.internProduction({ {}, {2} })));
+}
+
+TEST(ProductionEnumerator, test_0) {
+
+// a [b | c d] [e]
+  Expr expr{.kind = Expr::Kind::sequence, .children = {
+    {.kind = Expr::Kind::symbol, .symbol = 0},
+    {.kind = Expr::Kind::optional, .children = {
+      {.kind = Expr::Kind::choice, .children = {
+        {.kind = Expr::Kind::symbol, .symbol = 1},
+        {.kind = Expr::Kind::sequence, .children = { {.kind = Expr::Kind::symbol, .symbol = 2}, {.kind = Expr::Kind::symbol, .symbol = 3} }},
+      }},
+    }},
+    {.kind = Expr::Kind::optional, .children = { {.kind = Expr::Kind::symbol, .symbol = 4} }},
+  }};
+
+  ProductionEnumerator productions(expr);
+  vector<vector<SymbolId>> enumerated;
+  for(vector<SymbolId> symbols; productions.next(symbols);) {
+    enumerated.push_back(symbols);
+  }
+
+  EXPECT_THAT(enumerated, ElementsAre(
+    vector<SymbolId>{0},
+    vector<SymbolId>{0, 4},
+    vector<SymbolId>{0, 1},
+    vector<SymbolId>{0, 1, 4},
+    vector<SymbolId>{0, 2, 3},
+    vector<SymbolId>{0, 2, 3, 4}
+  ));
+  EXPECT_EQ(enumerated.size(), predictSize(expr).numProductions);
+
+  vector<SymbolId> symbols;
+  EXPECT_FALSE(productions.next(symbols));
+}
+
+TEST(ProductionEnumerator, test_1) {
+
+// rule with only a comment has no productions
+  Expr empty;
+  vector<SymbolId> symbols;
+  EXPECT_FALSE(ProductionEnumerator(empty).next(symbols));
+
+// an alternative without productions is skipped, an optional of it is still empty
+  Expr expr{.kind = Expr::Kind::choice, .children = {
+    {},
+    {.kind = Expr::Kind::optional, .children = { {} }},
+    {.kind = Expr::Kind::sequence, .children = { {.kind = Expr::Kind::symbol, .symbol = 0}, {} }},
+  }};
+
+  ProductionEnumerator productions(expr);
+  EXPECT_TRUE(productions.next(symbols));
+  EXPECT_TRUE(symbols.empty());
+  EXPECT_FALSE(productions.next(symbols));
+}
+
+
+TEST(Arena, test_0) {
+
+  Arena arena;
+  {
+    pmr::vector<pmr::vector<SymbolId>> v(arena.resource());
+    for(SymbolId i = 0; i < 100; ++i) {
+      v.emplace_back(i + 1, i);
+    }
+  }
+
+// vector growth plus one allocation per element, all served from a few heap chunks
+  EXPECT_GT(arena.numAllocations(), 100);
+  EXPECT_LT(arena.numChunks(), 10);
+  EXPECT_GE(arena.chunkBytes(), arena.bytesAllocated());
+}
+
+TEST(TaskPool, test_0) {
+
+  TaskPool pool(4);
+  vector<atomic<int>> runs(1000);
+  for(int batch = 0; batch < 3; ++batch) {
+    pool.run(runs.size(), [&runs](size_t i) { ++runs[i]; });
+  }
+
+  EXPECT_TRUE(ranges::all_of(runs, [](const atomic<int>& n) { return n == 3; }));
+  EXPECT_EQ(pool.stats().numBatches, 3);
+  EXPECT_EQ(pool.stats().numTasks, 3000);
+  EXPECT_LE(pool.stats().maxTaskTime, pool.stats().taskTime);
+
+// a pool of 1 runs batches on the caller
+  TaskPool single(1);
+  int n = 0;
+  single.run(10, [&n](size_t) { ++n; });
+  EXPECT_EQ(n, 10);
+  EXPECT_EQ(single.stats().numTasksStolen, 0);
+}
+
+TEST(Expander, test_1) {
+
+// 16 optionals in a row, halves of 256 productions each are joined on the pool
+  Expr expr{.kind = Expr::Kind::sequence};
+  for(SymbolId i = 0; i < 16; ++i) {
+    expr.children.push_back({.kind = Expr::Kind::optional, .children = { {.kind = Expr::Kind::symbol, .symbol = i} }});
+  }
+
+  SequenceStore serialSequences;
+  auto serial = Expander(serialSequences, 0, {}, {})(expr);
+
+  SequenceStore sequences;
+  TaskPool pool(4);
+  auto parallel = Expander(sequences, 0, {}, {}, pmr::get_default_resource(), &pool)(expr);
+
+  EXPECT_EQ(parallel.size(), 1 << 16);
+  EXPECT_GT(pool.stats().numTasks, 0);
+  EXPECT_EQ(sequences.size(), serialSequences.size());
+  ASSERT_EQ(parallel.size(), serial.size());
+// same sequences in the same order, and each one already interned under its id
+  for(size_t i = 0; i < parallel.size(); ++i) {
+    auto symbols = sequences.symbols(parallel[i]);
+    EXPECT_EQ(symbols, serialSequences.symbols(serial[i]));
+    EXPECT_EQ(sequences.intern(symbols), parallel[i]);
+  }
+}
+
+}
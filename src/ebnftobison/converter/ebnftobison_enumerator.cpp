@@ -0,0 +1,180 @@
+// ebnftobison_enumerator.cpp
+
+/*
+MIT License
+
+Copyright (c) 2024 Zartaj Majeed
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "converter/ebnftobison_enumerator.h"
+
+namespace ebnftobison {
+
+ProductionEnumerator::ProductionEnumerator(const Expr& expr) {
+  addCursor(expr);
+}
+
+// children of a cursor are added after it and their indexes reserved together so they're contiguous in childCursors
+uint32_t ProductionEnumerator::addCursor(const Expr& expr) {
+  auto cursor = static_cast<uint32_t>(cursors.size());
+  cursors.push_back({.expr = &expr});
+  auto firstChild = static_cast<uint32_t>(childCursors.size());
+  cursors[cursor].firstChild = firstChild;
+  childCursors.resize(childCursors.size() + expr.children.size());
+  for(size_t i = 0; i < expr.children.size(); ++i) {
+    auto childCursor = addCursor(expr.children[i]);
+    childCursors[firstChild + i] = childCursor;
+  }
+  return cursor;
+}
+
+bool ProductionEnumerator::next(vector<SymbolId>& symbols) {
+  if(done) {
+    return false;
+  }
+  done = started? !advance(0): !reset(0);
+  started = true;
+  if(done) {
+    return false;
+  }
+  symbols.clear();
+  appendSymbols(0, symbols);
+  return true;
+}
+
+bool ProductionEnumerator::reset(uint32_t cursor) {
+  auto& c = cursors[cursor];
+  const auto& children = c.expr->children;
+  switch(c.expr->kind) {
+  case Expr::Kind::symbol:
+    return true;
+  case Expr::Kind::optional:
+    c.position = 0;
+    return true;
+  case Expr::Kind::choice:
+    for(c.position = 0; c.position < children.size(); ++c.position) {
+      if(reset(child(cursor, c.position))) {
+        return true;
+      }
+    }
+    return false;
+  case Expr::Kind::sequence:
+    for(size_t i = 0; i < children.size(); ++i) {
+      if(!reset(child(cursor, i))) {
+        return false;
+      }
+    }
+    return true;
+  case Expr::Kind::repetition:
+    break;
+  }
+  return false;
+}
+
+bool ProductionEnumerator::advance(uint32_t cursor) {
+  auto& c = cursors[cursor];
+  const auto& children = c.expr->children;
+  switch(c.expr->kind) {
+  case Expr::Kind::symbol:
+    return false;
+  case Expr::Kind::optional:
+    if(c.position == 0) {
+      c.position = 1;
+      return reset(child(cursor, 0));
+    }
+    return advance(child(cursor, 0));
+  case Expr::Kind::choice:
+    if(advance(child(cursor, c.position))) {
+      return true;
+    }
+    while(++c.position < children.size()) {
+      if(reset(child(cursor, c.position))) {
+        return true;
+      }
+    }
+    return false;
+// odometer over children, later children wrap around before earlier ones move
+  case Expr::Kind::sequence:
+    for(auto i = children.size(); i-- > 0;) {
+      if(advance(child(cursor, i))) {
+        return true;
+      }
+      reset(child(cursor, i));
+    }
+    return false;
+  case Expr::Kind::repetition:
+    break;
+  }
+  return false;
+}
+
+void ProductionEnumerator::appendSymbols(uint32_t cursor, vector<SymbolId>& symbols) const {
+  const auto& c = cursors[cursor];
+  const auto& children = c.expr->children;
+  switch(c.expr->kind) {
+  case Expr::Kind::symbol:
+    symbols.push_back(c.expr->symbol);
+    break;
+  case Expr::Kind::optional:
+    if(c.position == 1) {
+      appendSymbols(child(cursor, 0), symbols);
+    }
+    break;
+  case Expr::Kind::choice:
+    appendSymbols(child(cursor, c.position), symbols);
+    break;
+  case Expr::Kind::sequence:
+    for(size_t i = 0; i < children.size(); ++i) {
+      appendSymbols(child(cursor, i), symbols);
+    }
+    break;
+  case Expr::Kind::repetition:
+    break;
+  }
+}
+
+// two independent 64 bit hashes of the length and symbols, each symbol is mixed in with a splitmix64 step
+ProductionSet::Fingerprint ProductionSet::fingerprint(span<const SymbolId> symbols) {
+  auto mix = [](uint64_t x) {
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ull;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebull;
+    return x ^ (x >> 31);
+  };
+  Fingerprint f{.low = symbols.size(), .high = ~uint64_t{symbols.size()}};
+  for(auto symbol: symbols) {
+    f.low = mix(f.low + 0x9e3779b97f4a7c15ull + symbol);
+    f.high = mix(f.high ^ (symbol * 0xc2b2ae3d27d4eb4full + 0x165667b19e3779f9ull));
+  }
+  return f;
+}
+
+uint64_t countDistinctProductions(const Expr& expr, ProductionSet& distinct) {
+  distinct.clear();
+  ProductionEnumerator productions(expr);
+  for(vector<SymbolId> symbols; productions.next(symbols);) {
+    distinct.insert(symbols);
+  }
+  return distinct.size();
+}
+
+}
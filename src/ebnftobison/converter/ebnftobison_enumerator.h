@@ -0,0 +1,121 @@
+#ifndef EBNFTOBISON_ENUMERATOR_H
+#define EBNFTOBISON_ENUMERATOR_H
+// ebnftobison_enumerator.h
+
+/*
+MIT License
+
+Copyright (c) 2024 Zartaj Majeed
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <cstdint>
+#include <span>
+#include <unordered_set>
+#include <vector>
+
+#include "converter/ebnftobison_expr.h"
+
+namespace ebnftobison {
+using namespace std;
+
+// enumerates productions of an expr tree one at a time without expanding the whole tree
+// holds one cursor per tree node so memory is proportional to the tree, not to its expansion
+// order is fixed by the tree: alternatives in parsed order, empty before anything else in an optional, last child of a concatenation varies fastest
+// productions are not deduplicated, a tree like [a] [a] gives a twice, ProductionSet skips repeats
+// tree must not have repetitions, they are replaced by list rules first
+class ProductionEnumerator {
+public:
+
+  explicit ProductionEnumerator(const Expr& expr);
+
+// replaces symbols with next production, returns false once all productions have been given
+  bool next(vector<SymbolId>& symbols);
+
+private:
+
+  struct Cursor {
+    const Expr* expr;
+// chosen alternative of a choice, 0 for empty and 1 for child of an optional
+    uint32_t position = 0;
+// cursors of children are in childCursors starting here
+    uint32_t firstChild = 0;
+  };
+
+  uint32_t addCursor(const Expr& expr);
+
+// positions cursor at its first production, false if it has none
+  bool reset(uint32_t cursor);
+
+// moves cursor to its next production, false if it was at its last
+  bool advance(uint32_t cursor);
+
+  void appendSymbols(uint32_t cursor, vector<SymbolId>& symbols) const;
+
+  uint32_t child(uint32_t cursor, size_t i) const {
+    return childCursors[cursors[cursor].firstChild + i];
+  }
+
+  vector<Cursor> cursors;
+  vector<uint32_t> childCursors;
+  bool started = false;
+  bool done = false;
+
+};
+
+// productions of one rule kept as 128 bit fingerprints instead of their symbols, 16 bytes a production
+// two different productions would only share a fingerprint by chance, unlikely before 2^64 productions
+class ProductionSet {
+public:
+
+// false if symbols were already in the set
+  bool insert(span<const SymbolId> symbols) { return fingerprints.insert(fingerprint(symbols)).second; }
+
+// false if symbols weren't in the set
+  bool erase(span<const SymbolId> symbols) { return fingerprints.erase(fingerprint(symbols)) != 0; }
+
+  size_t size() const { return fingerprints.size(); }
+
+  void clear() { fingerprints.clear(); }
+
+private:
+
+  struct Fingerprint {
+    uint64_t low;
+    uint64_t high;
+    bool operator==(const Fingerprint&) const = default;
+  };
+
+  struct FingerprintHash {
+    size_t operator()(const Fingerprint& f) const { return f.low; }
+  };
+
+  static Fingerprint fingerprint(span<const SymbolId> symbols);
+
+  unordered_set<Fingerprint, FingerprintHash> fingerprints;
+
+};
+
+// number of distinct productions of expr, memory is the fingerprints of one rule
+uint64_t countDistinctProductions(const Expr& expr, ProductionSet& distinct);
+
+}
+
+#endif
@@ -0,0 +1,129 @@
+// ebnftobison_expander.cpp
+
+/*
+MIT License
+
+Copyright (c) 2024 Zartaj Majeed
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <algorithm>
+#include <iterator>
+
+#include "converter/ebnftobison_expander.h"
+
+namespace ebnftobison {
+
+// children are expanded before they are combined, same order the parser used to reduce them in
+Production Expander::operator()(const Expr& expr) const {
+  switch(expr.kind) {
+  case Expr::Kind::symbol:
+    return Production({sequences.append(SequenceStore::emptySequence, expr.symbol)}, resource);
+  case Expr::Kind::repetition: {
+    const auto& repeated = expr.children.front();
+    return repeat(repeated, (*this)(repeated));
+  }
+  case Expr::Kind::optional: {
+    auto production = (*this)(expr.children.front());
+// empty alternative comes first, or stays where the child already had it
+    production.insert(production.begin(), SequenceStore::emptySequence);
+    sequences.removeDuplicates(production);
+    return production;
+  }
+  case Expr::Kind::choice: {
+    Production production(resource);
+    for(const auto& child: expr.children) {
+      auto childProduction = (*this)(child);
+      production.insert(production.end(), childProduction.begin(), childProduction.end());
+    }
+    sequences.removeDuplicates(production);
+    return production;
+  }
+  case Expr::Kind::sequence: {
+    if(factorThreshold == 0) {
+      return product(expr.children, 0, expr.children.size());
+    }
+// factoring decisions depend on the size of everything to the left so children are joined one at a time
+    auto production = (*this)(expr.children.front());
+    for(auto i = next(expr.children.begin()); i != expr.children.end(); ++i) {
+      production = concatenate(std::move(production), (*this)(*i));
+    }
+    return production;
+  }
+  }
+  return Production(resource);
+}
+
+// children are still expanded left to right so helper rules are made in the same order
+Production Expander::product(const vector<Expr>& children, size_t first, size_t last) const {
+  if(last - first == 1) {
+    return (*this)(children[first]);
+  }
+  auto middle = first + (last - first) / 2;
+  auto left = product(children, first, middle);
+  return concatenate(std::move(left), product(children, middle, last));
+}
+
+Production Expander::concatenate(Production&& left, Production&& right) const {
+  Production production(resource);
+// k optionals in a row distribute to 2^k productions, a helper rule keeps this concatenation at the size of its left side
+  if(factorThreshold > 0 && right.size() > 1 && left.size() * right.size() > factorThreshold) {
+    auto helperName = factor(std::move(right));
+    production.reserve(left.size());
+    for(auto v: left) {
+      production.push_back(sequences.append(v, helperName));
+    }
+  } else if(pool != nullptr && pool->numThreads() > 1 && left.size() > 1 && left.size() * right.size() >= minParallelJoins) {
+    parallelProduct(left, right, production);
+  } else {
+    production.reserve(left.size() * right.size());
+    for(auto v: left) {
+      for(auto w: right) {
+        production.push_back(sequences.concatenate(v, w));
+      }
+    }
+  }
+  sequences.removeDuplicates(production);
+  return production;
+}
+
+// several tasks per thread so threads that finish early steal the rest
+void Expander::parallelProduct(const Production& left, const Production& right, Production& production) const {
+  production.resize(left.size() * right.size());
+  uint32_t maxSuffixLength = 0;
+  for(auto w: right) {
+    maxSuffixLength = max(maxSuffixLength, sequences.length(w));
+  }
+  auto numTasks = min(left.size(), 4 * pool->numThreads());
+  sequences.beginConcurrent(production.size(), maxSuffixLength);
+  pool->run(numTasks, [&](size_t task) {
+    auto first = task * left.size() / numTasks;
+    auto last = (task + 1) * left.size() / numTasks;
+    for(auto i = first; i < last; ++i) {
+      auto row = production.begin() + i * right.size();
+      for(auto w: right) {
+        *row++ = sequences.concurrentConcatenate(left[i], w);
+      }
+    }
+  });
+  sequences.endConcurrent();
+}
+
+}
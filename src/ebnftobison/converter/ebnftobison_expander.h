@@ -0,0 +1,82 @@
+#ifndef EBNFTOBISON_EXPANDER_H
+#define EBNFTOBISON_EXPANDER_H
+// ebnftobison_expander.h
+
+/*
+MIT License
+
+Copyright (c) 2024 Zartaj Majeed
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <cstdint>
+#include <functional>
+#include <memory_resource>
+
+#include "converter/ebnftobison_expr.h"
+#include "converter/ebnftobison_sequence_store.h"
+#include "converter/ebnftobison_task_pool.h"
+
+namespace ebnftobison {
+using namespace std;
+
+// expands expr trees to productions by distributing optionals and alternatives over concatenations
+// joined sequences are linked onto the sequences they extend in the store, never copied
+class Expander {
+public:
+
+// takes an optional or group moved out of a concatenation and returns the name of the helper rule that replaces it
+  using Factor = function<SymbolId(Production&&)>;
+
+// takes a repeated symbol or group with its expansion and returns productions of the list rules that replace it
+  using Repeat = function<Production(const Expr& repeated, Production&& production)>;
+
+// factorThreshold of 0 always distributes, otherwise any concatenation that would have more productions than this is factored
+// every production the expander builds is allocated from resource
+// with a pool large cross products are split by rows of their left side into tasks that join into the store concurrently
+  Expander(SequenceStore& sequences, uint64_t factorThreshold, Factor factor, Repeat repeat, pmr::memory_resource* resource = pmr::get_default_resource(), TaskPool* pool = nullptr): sequences(sequences), factorThreshold(factorThreshold), factor(std::move(factor)), repeat(std::move(repeat)), resource(resource), pool(pool) {}
+
+// cross products with fewer joins than this are built on the calling thread
+  static constexpr size_t minParallelJoins = 1 << 14;
+
+  Production operator()(const Expr& expr) const;
+
+private:
+
+  Production concatenate(Production&& left, Production&& right) const;
+
+// every sequence of left joined with every sequence of right, each task fills the rows of its own share of left
+  void parallelProduct(const Production& left, const Production& right, Production& production) const;
+
+// product of children first to last joined in halves, builds far fewer intermediate sequences than joining one child at a time
+  Production product(const vector<Expr>& children, size_t first, size_t last) const;
+
+  SequenceStore& sequences;
+  uint64_t factorThreshold;
+  Factor factor;
+  Repeat repeat;
+  pmr::memory_resource* resource;
+  TaskPool* pool;
+
+};
+
+}
+
+#endif
@@ -0,0 +1,95 @@
+// ebnftobison_expr.cpp
+
+/*
+MIT License
+
+Copyright (c) 2024 Zartaj Majeed
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <limits>
+
+#include "converter/ebnftobison_expr.h"
+
+namespace ebnftobison {
+
+namespace {
+
+uint64_t add(uint64_t a, uint64_t b) {
+  uint64_t sum;
+  return __builtin_add_overflow(a, b, &sum)? numeric_limits<uint64_t>::max(): sum;
+}
+
+uint64_t multiply(uint64_t a, uint64_t b) {
+  uint64_t product;
+  return __builtin_mul_overflow(a, b, &product)? numeric_limits<uint64_t>::max(): product;
+}
+
+}
+
+ExpansionSize predictSize(const Expr& expr) {
+  switch(expr.kind) {
+  case Expr::Kind::symbol:
+    return {1, 1, 0};
+  case Expr::Kind::repetition: {
+    const auto& repeated = expr.children.front();
+    if(repeated.kind == Expr::Kind::symbol) {
+      return {1, 1, 2};
+    }
+    auto repeatedSize = predictSize(repeated);
+    auto numListProductions = add(repeatedSize.numListProductions, repeatedSize.numProductions);
+    if(isChoiceGroup(repeated)) {
+      return {1, 1, add(numListProductions, 2)};
+    }
+// one list rule of two productions for every production of the group
+    return {repeatedSize.numProductions, repeatedSize.numProductions, add(numListProductions, repeatedSize.numProductions)};
+  }
+  case Expr::Kind::optional: {
+// empty alternative adds a production but no symbols
+    auto size = predictSize(expr.children.front());
+    size.numProductions = add(size.numProductions, 1);
+    return size;
+  }
+  case Expr::Kind::choice: {
+    ExpansionSize size;
+    for(const auto& child: expr.children) {
+      auto childSize = predictSize(child);
+      size.numProductions = add(size.numProductions, childSize.numProductions);
+      size.numSymbols = add(size.numSymbols, childSize.numSymbols);
+      size.numListProductions = add(size.numListProductions, childSize.numListProductions);
+    }
+    return size;
+  }
+  case Expr::Kind::sequence: {
+// every production of the left side is joined with every production of the right side
+    ExpansionSize size{1, 0, 0};
+    for(const auto& child: expr.children) {
+      auto childSize = predictSize(child);
+      size.numSymbols = add(multiply(size.numSymbols, childSize.numProductions), multiply(childSize.numSymbols, size.numProductions));
+      size.numProductions = multiply(size.numProductions, childSize.numProductions);
+      size.numListProductions = add(size.numListProductions, childSize.numListProductions);
+    }
+    return size;
+  }
+  }
+  return {};
+}
+
+}
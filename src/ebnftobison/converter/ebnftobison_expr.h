@@ -0,0 +1,75 @@
+#ifndef EBNFTOBISON_EXPR_H
+#define EBNFTOBISON_EXPR_H
+// ebnftobison_expr.h
+
+/*
+MIT License
+
+Copyright (c) 2024 Zartaj Majeed
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <cstdint>
+#include <vector>
+
+#include "converter/ebnftobison_symbol_table.h"
+
+namespace ebnftobison {
+using namespace std;
+
+// ebnf structure of a rule body as parsed, expanded to productions only once the whole rule has been seen
+struct Expr {
+  enum class Kind {
+// one alternative per child, no children for a rule that has only a comment
+    choice,
+// children concatenated in order
+    sequence,
+// single child or empty
+    optional,
+// single child repeated one or more times, a symbol or a group
+    repetition,
+    symbol
+  };
+  Kind kind = Kind::choice;
+  SymbolId symbol{};
+  vector<Expr> children{};
+};
+
+// repeated alternative group becomes a choice_group_N rule, any other repeated group a list rule per production
+inline bool isChoiceGroup(const Expr& group) {
+  return group.kind == Expr::Kind::choice && !group.children.empty();
+}
+
+// size of a fully distributed expansion, saturates instead of overflowing
+struct ExpansionSize {
+  uint64_t numProductions = 0;
+// symbols summed over all productions
+  uint64_t numSymbols = 0;
+// productions of the list and group rules made for repetitions
+  uint64_t numListProductions = 0;
+};
+
+// computes expansion size from products and sums over expr without building any productions
+// exact unless the expansion repeats an alternative, like [a] [a], then it's an upper bound
+ExpansionSize predictSize(const Expr& expr);
+
+}
+
+#endif
@@ -0,0 +1,68 @@
+// ebnftobison_name_normalizer.cpp
+
+/*
+MIT License
+
+Copyright (c) 2024 Zartaj Majeed
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <array>
+
+#include "converter/ebnftobison_name_normalizer.h"
+
+namespace ebnftobison {
+
+namespace {
+
+// bytes allowed in bison names, same set as the old regex [^a-zA-Z0-9_] excluded
+constexpr auto validNameBytes = [] {
+  array<bool, 256> valid{};
+  for(auto c = 'a'; c <= 'z'; ++c) {
+    valid[static_cast<unsigned char>(c)] = true;
+  }
+  for(auto c = 'A'; c <= 'Z'; ++c) {
+    valid[static_cast<unsigned char>(c)] = true;
+  }
+  for(auto c = '0'; c <= '9'; ++c) {
+    valid[static_cast<unsigned char>(c)] = true;
+  }
+  valid['_'] = true;
+  return valid;
+}();
+
+}
+
+const string& NameNormalizer::operator()(string_view nonterminal) {
+  if(auto i = names.find(nonterminal); i != names.end()) {
+    return i->second;
+  }
+
+  string name(nonterminal.substr(1, nonterminal.length() - 2));
+  for(auto& c: name) {
+    if(!validNameBytes[static_cast<unsigned char>(c)]) {
+      c = '_';
+    }
+  }
+
+  return names.emplace(nonterminal, std::move(name)).first->second;
+}
+
+}
@@ -0,0 +1,63 @@
+#ifndef EBNFTOBISON_NAME_NORMALIZER_H
+#define EBNFTOBISON_NAME_NORMALIZER_H
+// ebnftobison_name_normalizer.h
+
+/*
+MIT License
+
+Copyright (c) 2024 Zartaj Majeed
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <functional>
+
+namespace ebnftobison {
+using namespace std;
+
+// turns a raw <...> nonterminal into a name valid for bison
+// angle brackets are dropped and any character not in [a-zA-Z0-9_] becomes an underscore
+// each distinct nonterminal is normalized just once and the result is kept for the rest of the conversion
+class NameNormalizer {
+public:
+
+  const string& operator()(string_view nonterminal);
+
+  size_t size() const { return names.size(); }
+
+  void clear() { names.clear(); }
+
+private:
+
+  struct Hash {
+    using is_transparent = void;
+    size_t operator()(string_view s) const { return hash<string_view>{}(s); }
+  };
+
+// raw nonterminal with angle brackets to normalized name
+  unordered_map<string, string, Hash, equal_to<>> names;
+
+};
+
+}
+
+#endif
@@ -0,0 +1,279 @@
+// ebnftobison_sequence_store.cpp
+
+/*
+MIT License
+
+Copyright (c) 2024 Zartaj Majeed
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <thread>
+
+#include "converter/ebnftobison_sequence_store.h"
+
+namespace ebnftobison {
+
+namespace {
+
+const uint64_t hashBase = 0x100000001b3ull;
+
+uint64_t slotHash(uint64_t hash) {
+  hash *= 0x9e3779b97f4a7c15ull;
+  return hash ^ (hash >> 32);
+}
+
+}
+
+SequenceStore::SequenceStore() {
+  clear();
+}
+
+SequenceId SequenceStore::concatenate(SequenceId prefix, SequenceId suffix) {
+  if(prefix == emptySequence) {
+    return suffix;
+  }
+  if(suffix == emptySequence) {
+    return prefix;
+  }
+  while(powers.size() <= nodes[suffix].length) {
+    powers.push_back(powers.back() * hashBase);
+  }
+  return find(joinNode(prefix, suffix));
+}
+
+SequenceStore::Node SequenceStore::joinNode(SequenceId prefix, SequenceId suffix) const {
+  const auto& left = nodes[prefix];
+  const auto& right = nodes[suffix];
+  return {
+    .hash = left.hash * powers[right.length] + right.hash,
+    .length = left.length + right.length,
+    .left = prefix,
+    .right = suffix
+  };
+}
+
+void SequenceStore::beginConcurrent(size_t maxNewSequences, uint32_t maxSuffixLength) {
+  while(powers.size() <= maxSuffixLength) {
+    powers.push_back(powers.back() * hashBase);
+  }
+  auto numNodes = nodes.size() + maxNewSequences;
+  if(2 * numNodes >= slots.size()) {
+    auto numSlots = slots.size();
+    while(2 * numNodes >= numSlots) {
+      numSlots *= 2;
+    }
+    grow(numSlots);
+  }
+  numConcurrentNodes = nodes.size();
+  nodes.resize(numNodes);
+}
+
+// same probe as find, a thread that takes a free slot reserves it, writes its node and then publishes the id
+SequenceId SequenceStore::concurrentConcatenate(SequenceId prefix, SequenceId suffix) {
+  if(prefix == emptySequence) {
+    return suffix;
+  }
+  if(suffix == emptySequence) {
+    return prefix;
+  }
+  thread_local vector<SymbolId> candidateSymbols;
+  thread_local vector<SymbolId> nodeSymbols;
+  auto node = joinNode(prefix, suffix);
+  auto mask = slots.size() - 1;
+  for(auto i = slotHash(node.hash) & mask;; i = (i + 1) & mask) {
+    atomic_ref slot(slots[i]);
+    auto id = slot.load(memory_order::acquire);
+    if(id == emptySequence && slot.compare_exchange_strong(id, reservedSlot, memory_order::acquire)) {
+      id = static_cast<SequenceId>(atomic_ref(numConcurrentNodes).fetch_add(1, memory_order::relaxed));
+      nodes[id] = node;
+      slot.store(id, memory_order::release);
+      return id;
+    }
+    while(id == reservedSlot) {
+      this_thread::yield();
+      id = slot.load(memory_order::acquire);
+    }
+    if(nodes[id].hash == node.hash && nodes[id].length == node.length && sameSymbols(id, node, candidateSymbols, nodeSymbols)) {
+      return id;
+    }
+  }
+}
+
+void SequenceStore::endConcurrent() {
+  nodes.resize(numConcurrentNodes);
+}
+
+SequenceId SequenceStore::symbolSequence(SymbolId symbol) {
+  return find({
+    .hash = (symbol + 1ull) * 0x9e3779b97f4a7c15ull,
+    .length = 1,
+    .left = emptySequence,
+    .right = symbol
+  });
+}
+
+// returns id of the node with the same symbols, adding node if there is none
+SequenceId SequenceStore::find(const Node& node) {
+  if(2 * nodes.size() >= slots.size()) {
+    grow(2 * slots.size());
+  }
+  auto mask = slots.size() - 1;
+  for(auto i = slotHash(node.hash) & mask;; i = (i + 1) & mask) {
+    auto id = slots[i];
+    if(id == emptySequence) {
+      id = static_cast<SequenceId>(nodes.size());
+      nodes.push_back(node);
+      slots[i] = id;
+      return id;
+    }
+    if(nodes[id].hash == node.hash && nodes[id].length == node.length && sameSymbols(id, node)) {
+      return id;
+    }
+  }
+}
+
+// full comparison only when hashes match, which is almost always a repeated join
+bool SequenceStore::sameSymbols(SequenceId id, const Node& node) {
+  return sameSymbols(id, node, candidateSymbols, nodeSymbols);
+}
+
+bool SequenceStore::sameSymbols(SequenceId id, const Node& node, vector<SymbolId>& candidateSymbols, vector<SymbolId>& nodeSymbols) const {
+  const auto& candidate = nodes[id];
+  if(candidate.left == node.left && candidate.right == node.right) {
+    return true;
+  }
+  if(node.length == 1) {
+    return candidate.length == 1 && candidate.right == node.right;
+  }
+  candidateSymbols.clear();
+  appendSymbols(id, candidateSymbols);
+  nodeSymbols.clear();
+  appendSymbols(node.left, nodeSymbols);
+  appendSymbols(node.right, nodeSymbols);
+  return candidateSymbols == nodeSymbols;
+}
+
+SequenceId SequenceStore::intern(const vector<SymbolId>& symbols) {
+  auto id = emptySequence;
+  for(auto symbol: symbols) {
+    id = append(id, symbol);
+  }
+  return id;
+}
+
+Production SequenceStore::internProduction(const vector<vector<SymbolId>>& sequences) {
+  Production production;
+  production.reserve(sequences.size());
+  for(const auto& v: sequences) {
+    production.push_back(intern(v));
+  }
+  normalizeProduction(production);
+  return production;
+}
+
+vector<SymbolId> SequenceStore::symbols(SequenceId id) const {
+  vector<SymbolId> v;
+  v.reserve(nodes[id].length);
+  appendSymbols(id, v);
+  return v;
+}
+
+void SequenceStore::appendSymbols(SequenceId id, vector<SymbolId>& v) const {
+  const auto& node = nodes[id];
+  if(node.length == 0) {
+    return;
+  }
+  if(node.length == 1) {
+    v.push_back(node.right);
+    return;
+  }
+  appendSymbols(node.left, v);
+  appendSymbols(node.right, v);
+}
+
+void SequenceStore::removeDuplicates(Production& production) {
+  if(stamps.size() < nodes.size()) {
+    stamps.resize(nodes.size());
+  }
+// stamp 0 is never used so a wrapped stamp has to clear every mark
+  if(++stamp == 0) {
+    ranges::fill(stamps, 0);
+    stamp = 1;
+  }
+  auto distinct = production.begin();
+  for(auto id: production) {
+    if(stamps[id] != stamp) {
+      stamps[id] = stamp;
+      *distinct++ = id;
+    }
+  }
+  production.erase(distinct, production.end());
+}
+
+void SequenceStore::clear() {
+  nodes.assign(1, {.hash = 0, .length = 0, .left = emptySequence, .right = emptySequence});
+  slots.assign(1024, emptySequence);
+  powers.assign(1, 1);
+  stamps.clear();
+  stamp = 0;
+}
+
+// table stays at most half full
+void SequenceStore::grow(size_t numSlots) {
+  slots.assign(numSlots, emptySequence);
+  auto mask = slots.size() - 1;
+  for(SequenceId id = 1; id < nodes.size(); ++id) {
+    auto i = slotHash(nodes[id].hash) & mask;
+    while(slots[i] != emptySequence) {
+      i = (i + 1) & mask;
+    }
+    slots[i] = id;
+  }
+}
+
+// lengths are known from the store so the symbol buffer is sized exactly
+void FlatProductions::assign(const Production& production) {
+  size_t numSymbols = 0;
+  for(auto id: production) {
+    numSymbols += sequences.length(id);
+  }
+  symbols.clear();
+  symbols.reserve(numSymbols);
+  offsets.clear();
+  offsets.reserve(production.size() + 1);
+  offsets.push_back(0);
+  order.resize(production.size());
+  for(uint32_t k = 0; k < production.size(); ++k) {
+    sequences.appendSymbols(production[k], symbols);
+    offsets.push_back(symbols.size());
+    order[k] = k;
+  }
+}
+
+void FlatProductions::sort(const vector<uint32_t>& symbolRanks) {
+  auto rank = [&symbolRanks](SymbolId symbol) { return symbolRanks[symbol]; };
+  ranges::sort(order, [this, &rank](uint32_t a, uint32_t b) {
+    auto aSymbols = span(symbols).subspan(offsets[a], offsets[a + 1] - offsets[a]);
+    auto bSymbols = span(symbols).subspan(offsets[b], offsets[b + 1] - offsets[b]);
+    return ranges::lexicographical_compare(aSymbols, bSymbols, {}, rank, rank);
+  });
+}
+
+}
@@ -0,0 +1,173 @@
+#ifndef EBNFTOBISON_SEQUENCE_STORE_H
+#define EBNFTOBISON_SEQUENCE_STORE_H
+// ebnftobison_sequence_store.h
+
+/*
+MIT License
+
+Copyright (c) 2024 Zartaj Majeed
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <vector>
+#include <span>
+#include <memory_resource>
+
+#include "converter/ebnftobison_symbol_table.h"
+
+namespace ebnftobison {
+using namespace std;
+
+// id of a symbol sequence interned in a SequenceStore
+using SequenceId = uint32_t;
+
+// alternatives of a rule as ids of distinct sequences in the order they were expanded, sorted only when printed
+// allocated from the conversion arena while rules are expanded
+using Production = pmr::vector<SequenceId>;
+
+// hash-consed dag of symbol sequences
+// a sequence of two or more symbols is a node linking the two sequences it was joined from, so joining adds one node and copies no symbols
+// nodes are keyed by the symbols of their sequence, equal sequences always get the same id however they were joined
+class SequenceStore {
+public:
+
+  static constexpr SequenceId emptySequence = 0;
+
+  SequenceStore();
+
+  SequenceId append(SequenceId prefix, SymbolId symbol) {
+    return concatenate(prefix, symbolSequence(symbol));
+  }
+
+  SequenceId concatenate(SequenceId prefix, SequenceId suffix);
+
+// concurrentConcatenate can be called from several threads between beginConcurrent and endConcurrent, nothing else may be called meanwhile
+// room for maxNewSequences is made up front so the store never grows while threads are adding to it
+// a free slot is claimed with a compare and swap, so equal joins from different threads still get one id, though which id depends on timing
+  void beginConcurrent(size_t maxNewSequences, uint32_t maxSuffixLength);
+  SequenceId concurrentConcatenate(SequenceId prefix, SequenceId suffix);
+  void endConcurrent();
+
+  SequenceId intern(const vector<SymbolId>& symbols);
+
+// sorted ids of all given sequences
+  Production internProduction(const vector<vector<SymbolId>>& sequences);
+
+// drops repeated ids keeping the first of each in place
+// a stamp per sequence id marks ids already seen so nothing is sorted or hashed
+  void removeDuplicates(Production& production);
+
+// flat sequence, only needed for printing and naming
+  vector<SymbolId> symbols(SequenceId id) const;
+  void appendSymbols(SequenceId id, vector<SymbolId>& v) const;
+
+  uint32_t length(SequenceId id) const { return nodes[id].length; }
+
+// number of nodes including the empty sequence
+  size_t size() const { return nodes.size(); }
+
+  size_t bytesUsed() const { return nodes.capacity() * sizeof(Node) + slots.capacity() * sizeof(SequenceId) + stamps.capacity() * sizeof(uint32_t); }
+
+  void clear();
+
+private:
+
+  struct Node {
+// polynomial hash of the symbols, hash of a join is computed from the hashes of its parts
+    uint64_t hash;
+    uint32_t length;
+// parts of a join, a single symbol is kept in right
+    SequenceId left;
+    SequenceId right;
+  };
+
+  SequenceId symbolSequence(SymbolId symbol);
+
+  SequenceId find(const Node& node);
+
+  bool sameSymbols(SequenceId id, const Node& node);
+  bool sameSymbols(SequenceId id, const Node& node, vector<SymbolId>& candidateSymbols, vector<SymbolId>& nodeSymbols) const;
+
+  Node joinNode(SequenceId prefix, SequenceId suffix) const;
+
+// rebuilds the index with numSlots slots, a power of 2
+  void grow(size_t numSlots);
+
+  vector<Node> nodes;
+// number of nodes in use while nodes is sized ahead for concurrent joins
+  size_t numConcurrentNodes = 0;
+// open addressing index of nodes by hash, emptySequence marks a free slot since its node is never indexed
+  vector<SequenceId> slots;
+// powers of the hash base by sequence length
+  vector<uint64_t> powers;
+// flat symbols of two sequences with equal hashes being compared
+  vector<SymbolId> candidateSymbols;
+  vector<SymbolId> nodeSymbols;
+// slot being filled by a concurrent join, other joins probing it wait until the node is in place
+  static constexpr SequenceId reservedSlot = UINT32_MAX;
+// stamp of the last removeDuplicates call that saw each id
+  vector<uint32_t> stamps;
+  uint32_t stamp = 0;
+
+};
+
+// sequences of one production flattened into a single symbol buffer with an offset per sequence
+// sorting and printing then run over contiguous symbols instead of walking the store, buffers are reused from rule to rule
+class FlatProductions {
+public:
+
+  explicit FlatProductions(const SequenceStore& sequences): sequences(sequences) {}
+
+  void assign(const Production& production);
+
+// orders sequences the same as comparing their symbol vectors by symbolRanks, a prefix comes before anything it starts
+  void sort(const vector<uint32_t>& symbolRanks);
+
+  size_t size() const { return order.size(); }
+
+// i-th sequence in sorted order
+  span<const SymbolId> operator[](size_t i) const {
+    auto k = order[i];
+    return span(symbols).subspan(offsets[k], offsets[k + 1] - offsets[k]);
+  }
+
+private:
+
+  const SequenceStore& sequences;
+  vector<SymbolId> symbols;
+// sequence k is symbols from offsets[k] up to offsets[k + 1]
+  vector<size_t> offsets;
+  vector<uint32_t> order;
+
+};
+
+// sorts ids and drops duplicates so productions merge and compare like sets
+inline void normalizeProduction(Production& production) {
+  ranges::sort(production);
+  auto duplicates = ranges::unique(production);
+  production.erase(duplicates.begin(), duplicates.end());
+}
+
+}
+
+#endif
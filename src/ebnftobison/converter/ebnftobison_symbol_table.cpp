@@ -0,0 +1,75 @@
+// ebnftobison_symbol_table.cpp
+
+/*
+MIT License
+
+Copyright (c) 2024 Zartaj Majeed
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <algorithm>
+#include <numeric>
+
+#include "converter/ebnftobison_symbol_table.h"
+
+namespace ebnftobison {
+
+SymbolId SymbolTable::intern(string_view name) {
+  if(auto i = index.find(name); i != index.end()) {
+    return i->second;
+  }
+  auto id = static_cast<SymbolId>(symbolNames.size());
+  const auto& s = symbolNames.emplace_back(name);
+  index.emplace(s, id);
+  return id;
+}
+
+vector<string> SymbolTable::names(const vector<SymbolId>& symbols) const {
+  vector<string> v;
+  v.reserve(symbols.size());
+  for(auto id: symbols) {
+    v.push_back(name(id));
+  }
+  return v;
+}
+
+bool SymbolTable::less(const vector<SymbolId>& a, const vector<SymbolId>& b) const {
+  return ranges::lexicographical_compare(a, b, [this](SymbolId x, SymbolId y) {
+    return x != y && name(x) < name(y);
+  });
+}
+
+vector<uint32_t> SymbolTable::nameRanks() const {
+  vector<SymbolId> ids(symbolNames.size());
+  iota(ids.begin(), ids.end(), 0);
+  ranges::sort(ids, {}, [this](SymbolId id) -> const string& { return name(id); });
+  vector<uint32_t> ranks(ids.size());
+  for(uint32_t rank = 0; rank < ids.size(); ++rank) {
+    ranks[ids[rank]] = rank;
+  }
+  return ranks;
+}
+
+void SymbolTable::clear() {
+  index.clear();
+  symbolNames.clear();
+}
+
+}
@@ -0,0 +1,73 @@
+#ifndef EBNFTOBISON_SYMBOL_TABLE_H
+#define EBNFTOBISON_SYMBOL_TABLE_H
+// ebnftobison_symbol_table.h
+
+/*
+MIT License
+
+Copyright (c) 2024 Zartaj Majeed
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace ebnftobison {
+using namespace std;
+
+// compact id for an interned nonterminal, token or literal name
+using SymbolId = uint32_t;
+
+// interns every distinct symbol name once for the whole conversion
+// productions hold ids and names are looked up again only when the grammar is printed
+class SymbolTable {
+public:
+
+  SymbolId intern(string_view name);
+
+  const string& name(SymbolId id) const { return symbolNames[id]; }
+
+  vector<string> names(const vector<SymbolId>& symbols) const;
+
+// compares symbol sequences by name, gives the same order as comparing vectors of names
+  bool less(const vector<SymbolId>& a, const vector<SymbolId>& b) const;
+
+// position of every symbol in name order, indexed by id
+  vector<uint32_t> nameRanks() const;
+
+  size_t size() const { return symbolNames.size(); }
+
+  void clear();
+
+private:
+
+// deque never moves its strings so views of them in the index stay valid
+  deque<string> symbolNames;
+  unordered_map<string_view, SymbolId> index;
+
+};
+
+}
+
+#endif
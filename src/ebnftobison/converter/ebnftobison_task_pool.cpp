@@ -0,0 +1,164 @@
+// ebnftobison_task_pool.cpp
+
+/*
+MIT License
+
+Copyright (c) 2024 Zartaj Majeed
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <algorithm>
+
+#include "converter/ebnftobison_task_pool.h"
+
+namespace ebnftobison {
+
+TaskPool::TaskPool(size_t numThreads) {
+  numThreads = max<size_t>(numThreads, 1);
+  for(size_t i = 0; i < numThreads; ++i) {
+    queues.push_back(make_unique<Queue>());
+  }
+  for(size_t i = 1; i < numThreads; ++i) {
+    workers.emplace_back([this, i] { workerLoop(i); });
+  }
+}
+
+TaskPool::~TaskPool() {
+  {
+    lock_guard lock(m);
+    stopping = true;
+  }
+  wake.notify_all();
+// workers are joined here while the mutex and condition variables they wait on are still alive
+  workers.clear();
+}
+
+void TaskPool::run(size_t numTasks, const function<void(size_t)>& task) {
+  if(numTasks == 0) {
+    return;
+  }
+  {
+    lock_guard lock(m);
+    for(size_t i = 0; i < numTasks; ++i) {
+      auto& queue = *queues[i % queues.size()];
+      lock_guard queueLock(queue.m);
+      queue.tasks.push_back(i);
+    }
+    current = &task;
+    numRemaining = numTasks;
+    ++generation;
+  }
+  wake.notify_all();
+
+  work(0, task);
+
+// a worker still holding task has to let go of it before run returns
+  unique_lock lock(m);
+  done.wait(lock, [this] { return numRemaining == 0 && numActive == 0; });
+  current = nullptr;
+
+  ++totals.numBatches;
+  for(auto& queue: queues) {
+    auto& s = queue->stats;
+    totals.numTasks += s.numTasks;
+    totals.numTasksStolen += s.numTasksStolen;
+    totals.taskTime += s.taskTime;
+    totals.maxTaskTime = max(totals.maxTaskTime, s.maxTaskTime);
+    s = {};
+  }
+}
+
+// a worker that wakes after its batch is over finds current cleared and goes back to sleep
+void TaskPool::workerLoop(size_t self) {
+  uint64_t seenGeneration = 0;
+  for(;;) {
+    const function<void(size_t)>* task;
+    {
+      unique_lock lock(m);
+      wake.wait(lock, [&] { return stopping || generation != seenGeneration; });
+      if(stopping) {
+        return;
+      }
+      seenGeneration = generation;
+      task = current;
+      if(task == nullptr) {
+        continue;
+      }
+      ++numActive;
+    }
+    work(self, *task);
+    {
+      lock_guard lock(m);
+      --numActive;
+    }
+    done.notify_all();
+  }
+}
+
+void TaskPool::work(size_t self, const function<void(size_t)>& task) {
+  auto& stats = queues[self]->stats;
+  size_t i;
+  bool stolen;
+  while(take(self, i, stolen)) {
+    auto startTime = steady_clock::now();
+    task(i);
+    duration<double> taskTime = steady_clock::now() - startTime;
+    ++stats.numTasks;
+    stats.numTasksStolen += stolen;
+    stats.taskTime += taskTime;
+    stats.maxTaskTime = max(stats.maxTaskTime, taskTime);
+
+    bool isLast;
+    {
+      lock_guard lock(m);
+      isLast = --numRemaining == 0;
+    }
+    if(isLast) {
+      done.notify_all();
+    }
+  }
+}
+
+// tasks are never added while a batch runs so once every queue is seen empty there is nothing left to take
+bool TaskPool::take(size_t self, size_t& task, bool& stolen) {
+  {
+    auto& queue = *queues[self];
+    lock_guard lock(queue.m);
+    if(!queue.tasks.empty()) {
+      task = queue.tasks.back();
+      queue.tasks.pop_back();
+      stolen = false;
+      return true;
+    }
+  }
+  for(size_t k = 1; k < queues.size(); ++k) {
+    auto& queue = *queues[(self + k) % queues.size()];
+    lock_guard lock(queue.m);
+    if(!queue.tasks.empty()) {
+      task = queue.tasks.front();
+      queue.tasks.pop_front();
+      stolen = true;
+      return true;
+    }
+  }
+  return false;
+}
+
+}
@@ -0,0 +1,111 @@
+#ifndef EBNFTOBISON_TASK_POOL_H
+#define EBNFTOBISON_TASK_POOL_H
+// ebnftobison_task_pool.h
+
+/*
+MIT License
+
+Copyright (c) 2024 Zartaj Majeed
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace ebnftobison {
+using namespace std;
+using namespace chrono;
+
+// work-stealing pool that runs batches of numbered tasks
+// tasks of a batch are dealt out to a queue per thread, a thread takes from the back of its own queue and steals from the front of the others when it runs out
+// the thread calling run works on the batch too so a pool of 1 thread runs everything on the caller
+class TaskPool {
+public:
+
+  struct Stats {
+    uint64_t numBatches = 0;
+    uint64_t numTasks = 0;
+// tasks run by a thread other than the one they were dealt to
+    uint64_t numTasksStolen = 0;
+    duration<double> taskTime{};
+    duration<double> maxTaskTime{};
+  };
+
+  explicit TaskPool(size_t numThreads);
+
+  TaskPool(const TaskPool&) = delete;
+  TaskPool& operator=(const TaskPool&) = delete;
+
+  ~TaskPool();
+
+  size_t numThreads() const { return queues.size(); }
+
+// calls task(i) once for every i below numTasks and returns when all have finished
+// tasks must not throw, only one batch runs at a time
+  void run(size_t numTasks, const function<void(size_t)>& task);
+
+  const Stats& stats() const { return totals; }
+
+  void resetStats() { totals = {}; }
+
+private:
+
+  struct Queue {
+    mutex m;
+    deque<size_t> tasks;
+// only touched by the thread that owns the queue while a batch runs
+    Stats stats;
+  };
+
+  void workerLoop(size_t self);
+
+// runs tasks of the current batch until every queue is empty
+  void work(size_t self, const function<void(size_t)>& task);
+
+  bool take(size_t self, size_t& task, bool& stolen);
+
+// queue 0 belongs to the thread calling run
+  vector<unique_ptr<Queue>> queues;
+  vector<jthread> workers;
+
+  mutex m;
+  condition_variable wake;
+  condition_variable done;
+// guarded by m
+  uint64_t generation = 0;
+  const function<void(size_t)>* current = nullptr;
+  size_t numActive = 0;
+  size_t numRemaining = 0;
+  bool stopping = false;
+
+  Stats totals;
+
+};
+
+}
+
+#endif
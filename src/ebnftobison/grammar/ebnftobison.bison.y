@@ -61,28 +61,55 @@ SOFTWARE.
 // standard c++ #includes and defines
 
 #include <string>
+#include <string_view>
 #include <functional>
 #include <chrono>
 #include <map>
 #include <set>
 #include <vector>
+#include <memory>
 
 #include "locations.bison.h"
 
+#include "converter/ebnftobison_symbol_table.h"
+#include "converter/ebnftobison_name_normalizer.h"
+#include "converter/ebnftobison_sequence_store.h"
+#include "converter/ebnftobison_expr.h"
+#include "converter/ebnftobison_expander.h"
+#include "converter/ebnftobison_arena.h"
+#include "converter/ebnftobison_task_pool.h"
+
 namespace ebnftobison {
 
 using namespace std;
 using namespace chrono;
 
-using Production = set<vector<string>>;
-using Rule = map<string, set<vector<string>>>;
+using Rule = pmr::map<SymbolId, Production>;
+
+// same rules with symbol ids resolved to names
+using NamedRule = map<string, set<vector<string>>>;
 
 struct Combo {
   enum class Type {
     concatenation,
     alternative
   } comboType;
-  Production production;
+  Expr expr;
+};
+
+// how a helper rule name was made, lets names be rebuilt when rules parsed separately are merged
+struct HelperName {
+  enum class Counter {
+// list rule named after sequences
+    none,
+    optional,
+    group,
+    choiceGroup
+  } counter = Counter::none;
+  uint64_t number = 0;
+// list rule name is built from these sequences taken in name order up to and including sequences[last]
+  shared_ptr<const vector<vector<SymbolId>>> sequences{};
+  size_t last = 0;
 };
 
 struct BisonParam {
@@ -92,8 +119,111 @@ struct BisonParam {
     time_point<steady_clock> parseEndTime;
     uint64_t numRulesParsed = 0;
     uint64_t numRulesGenerated = 0;
+    uint64_t numProductionsGenerated = 0;
+    uint64_t numOptionalsFactored = 0;
+    uint64_t numGroupsFactored = 0;
+// also numbers the next choice_group_N
+    uint64_t numChoiceGroups = 0;
+    uint64_t numRulesOverBudget = 0;
+// cross product tasks run by the expansion pool
+    uint64_t numExpandTasks = 0;
+    uint64_t numExpandTasksStolen = 0;
+    duration<double> expandTaskTime{};
+    duration<double> maxExpandTaskTime{};
+// rules loaded from and converted for a rule cache
+    uint64_t numRuleCacheHits = 0;
+    uint64_t numRuleCacheMisses = 0;
   } stats;
-  Rule result;
+  struct Options {
+// optionals and alternative groups in a concatenation are moved to helper rules opt_N and grp_N instead of being distributed
+// when the cross product would have more productions than this, 0 always distributes
+    uint64_t factorThreshold = 0;
+// most productions a rule and the list rules for its repetitions may expand to, 0 for no limit
+// a rule predicted to go over is factored down to the budget or fails the parse when refuseOverBudget is set
+    uint64_t productionBudget = 0;
+    bool refuseOverBudget = false;
+// rules are kept as ebnf trees in ruleTrees instead of being expanded into result, factoring and budget don't apply
+    bool keepTrees = false;
+// every helper rule name made is recorded in helperNames
+    bool recordHelperNames = false;
+// threads that large cross products of a single rule are split over, 1 expands everything on the parsing thread
+    size_t expandThreads = 1;
+  } options;
+// expanded productions and result live here until BisonParam goes away
+  Arena arena;
+  SymbolTable symbols;
+  NameNormalizer normalizeName;
+// every production in result and every one handed to ruleSink is an id in this store
+  SequenceStore sequences;
+  Rule result{arena.resource()};
+// rule bodies with repetitions replaced by list rules, only filled when options.keepTrees is set
+  map<SymbolId, Expr> ruleTrees;
+// predicted size of every parsed rule
+  map<SymbolId, ExpansionSize> predictedSizes;
+// only filled when options.recordHelperNames is set
+  map<SymbolId, HelperName> helperNames;
+// errors reported by the parser in the order they happened, nothing is written to cerr so parsers can run side by side on different threads
+  vector<string> diagnostics;
+// made on first use when options.expandThreads is more than 1
+  unique_ptr<TaskPool> taskPool;
+
+// optional consumer of finished rules
+// when set every rule is handed over as soon as it's reduced and nothing is collected in result
+// not used for rules kept as trees
+  function<void(SymbolId ruleName, Production&& production)> ruleSink;
+
+  void addRule(SymbolId ruleName, Production&& production);
+
+  void addRuleTree(SymbolId ruleName, Expr&& expr);
+
+// adds helper rule for production and returns its name
+  SymbolId factorProduction(Production&& production);
+
+// adds list rules for a repeated symbol or group and returns productions that refer to them
+  Production repeatProduction(const Expr& repeated, Production&& production);
+
+// adds left-recursive list rule for element and returns its name
+  SymbolId addListRule(SymbolId element);
+
+  SymbolId nextChoiceGroupName();
+
+// opt_N, grp_N or choice_group_N
+  static string counterName(HelperName::Counter counter, uint64_t number);
+
+// names of the symbols of sequence each followed by _ and then list
+// a repeated concatenation group keeps appending to the same name for each of its sequences
+  void appendListRuleName(string& listRuleName, const vector<SymbolId>& sequence) const;
+
+  void recordHelperName(SymbolId helper, HelperName&& helperName) {
+    if(options.recordHelperNames) {
+      helperNames.try_emplace(helper, std::move(helperName));
+    }
+  }
+
+// replaces repetitions in expr with list rules, same helper rules and names as expanding the rule would make
+  Expr lowerRepetitions(Expr&& expr);
+
+// tree of a single choice between the sequences of production
+  Expr productionTree(const Production& production) const;
+
+// expands rule body after checking its predicted size against the budget
+  Production expandRule(SymbolId ruleName, const Expr& expr, const location& loc);
+
+// pool for the expander, nullptr when expansion is not split over threads
+  TaskPool* expansionPool();
+
+  NamedRule namedResult() const;
+
+  set<vector<string>> namedProduction(const Production& production) const;
+
+  SymbolId internNonterminal(string_view nonterminal) {
+    return symbols.intern(normalizeName(nonterminal));
+  }
+
+// forgets everything from the last conversion so another one can start
+// options, ruleSink and the task pool are kept, containers hold on to what they allocated where they can
+// with keepSymbols interned symbols and normalized names stay as well, names seen before are then found without allocating
+  void clear(bool keepSymbols = false);
 };
 
 }
@@ -123,6 +253,9 @@ struct BisonParam {
 // use actual types for tokens
 %define api.value.type variant
 
+// every $x is moved from, so each value is used only once per action
+%define api.value.automove
+
 // use c++ objects, changes signature of yylex, yylex now returns EbnfToBison::symbol_type, yylex takes no parameters, change everywhere yylex is referenced, eg parse-param, any lambdas
 %define api.token.constructor
 
@@ -156,19 +289,260 @@ using namespace std;
 #include <vector>
 #include <map>
 #include <set>
-#include <regex>
+#include <algorithm>
+
+#include "converter/ebnftobison_enumerator.h"
 
 using namespace std;
 using namespace chrono;
 
 namespace {
   const auto defaultInputName = "inputstream"s;
-  uint64_t groupNumber;
+}
+
+// sink gets every rule as is, including repeated helper rules like lists of the same element
+// result keeps the first definition of a rule, same as merging rule maps
+void ebnftobison::BisonParam::addRule(SymbolId ruleName, Production&& production) {
+  if(options.keepTrees) {
+    addRuleTree(ruleName, productionTree(production));
+    return;
+  }
+  if(ruleSink) {
+    ++stats.numRulesGenerated;
+    stats.numProductionsGenerated += production.size();
+    ruleSink(ruleName, std::move(production));
+    return;
+  }
+  auto numProductions = production.size();
+  if(result.try_emplace(ruleName, std::move(production)).second) {
+    ++stats.numRulesGenerated;
+    stats.numProductionsGenerated += numProductions;
+  }
+}
+
+// tree is counted with the number of distinct productions it will print, same as the expanded rule
+void ebnftobison::BisonParam::addRuleTree(SymbolId ruleName, Expr&& expr) {
+  if(ruleTrees.contains(ruleName)) {
+    return;
+  }
+  ProductionSet distinct;
+  auto numProductions = countDistinctProductions(expr, distinct);
+  ruleTrees.emplace(ruleName, std::move(expr));
+  ++stats.numRulesGenerated;
+  stats.numProductionsGenerated += numProductions;
+}
+
+// helper is opt_N when production has an empty alternative, grp_N otherwise
+ebnftobison::SymbolId ebnftobison::BisonParam::factorProduction(Production&& production) {
+  auto isOptional = ranges::find(production, SequenceStore::emptySequence) != production.end();
+  auto counter = isOptional? HelperName::Counter::optional: HelperName::Counter::group;
+  auto number = isOptional? stats.numOptionalsFactored++: stats.numGroupsFactored++;
+  auto helperName = symbols.intern(counterName(counter, number));
+  recordHelperName(helperName, {.counter = counter, .number = number});
+  addRule(helperName, std::move(production));
+  return helperName;
+}
+
+// replace ellipsis repetition with new left-recursive rule to generate infinite sequences
+ebnftobison::Production ebnftobison::BisonParam::repeatProduction(const Expr& repeated, Production&& production) {
+  if(repeated.kind == Expr::Kind::symbol) {
+    return {sequences.intern({addListRule(repeated.symbol)})};
+  }
+
+  if(isChoiceGroup(repeated)) {
+// groups are replaced by new single nonterminal
+// move all productions of group to new rule for new nonterminal
+    auto groupName = nextChoiceGroupName();
+    addRule(groupName, std::move(production));
+    return {sequences.intern({addListRule(groupName)})};
+  }
+
+  Production listProduction(arena.resource());
+  string listRuleName;
+// list names are built in name order of the group's productions
+  auto productions = make_shared<vector<vector<SymbolId>>>();
+  for(auto id: production) {
+    productions->push_back(sequences.symbols(id));
+  }
+  ranges::sort(*productions, [this](const vector<SymbolId>& a, const vector<SymbolId>& b) { return symbols.less(a, b); });
+  for(size_t i = 0; i < productions->size(); ++i) {
+    const auto& v = (*productions)[i];
+    appendListRuleName(listRuleName, v);
+    auto listRuleId = symbols.intern(listRuleName);
+    recordHelperName(listRuleId, {.sequences = productions, .last = i});
+    auto w = v;
+    w.insert(w.begin(), listRuleId);
+    addRule(listRuleId, sequences.internProduction({ v, w }));
+    listProduction.push_back(sequences.intern({listRuleId}));
+  }
+  normalizeProduction(listProduction);
+  return listProduction;
+}
+
+ebnftobison::SymbolId ebnftobison::BisonParam::addListRule(SymbolId element) {
+  string name;
+  appendListRuleName(name, {element});
+  auto listRuleName = symbols.intern(name);
+  if(options.recordHelperNames) {
+    recordHelperName(listRuleName, {.sequences = make_shared<vector<vector<SymbolId>>>(1, vector<SymbolId>{element})});
+  }
+// left-recursive list rule for element elt
+// elt_list: elt | elt_list elt
+  addRule(listRuleName, sequences.internProduction({ {element}, {listRuleName, element} }));
+  return listRuleName;
+}
+
+ebnftobison::SymbolId ebnftobison::BisonParam::nextChoiceGroupName() {
+  auto number = stats.numChoiceGroups++;
+  auto groupName = symbols.intern(counterName(HelperName::Counter::choiceGroup, number));
+  recordHelperName(groupName, {.counter = HelperName::Counter::choiceGroup, .number = number});
+  return groupName;
+}
+
+string ebnftobison::BisonParam::counterName(HelperName::Counter counter, uint64_t number) {
+  stringstream s;
+  switch(counter) {
+  case HelperName::Counter::optional:
+    s << "opt_";
+    break;
+  case HelperName::Counter::group:
+    s << "grp_";
+    break;
+  case HelperName::Counter::choiceGroup:
+    s << "choice_group_";
+    break;
+  case HelperName::Counter::none:
+    break;
+  }
+  s << number;
+  return s.str();
+}
+
+void ebnftobison::BisonParam::appendListRuleName(string& listRuleName, const vector<SymbolId>& sequence) const {
+  for(auto e: sequence) {
+    listRuleName += symbols.name(e) + "_";
+  }
+  listRuleName += "list";
+}
+
+// children are lowered first and left to right, the order the expander visits repetitions in
+// a repeated choice group keeps its tree, only a repeated concatenation group is expanded since it needs a list rule per production
+ebnftobison::Expr ebnftobison::BisonParam::lowerRepetitions(Expr&& expr) {
+  for(auto& child: expr.children) {
+    child = lowerRepetitions(std::move(child));
+  }
+  if(expr.kind != Expr::Kind::repetition) {
+    return std::move(expr);
+  }
+
+  auto& repeated = expr.children.front();
+  if(repeated.kind == Expr::Kind::symbol) {
+    return {.kind = Expr::Kind::symbol, .symbol = addListRule(repeated.symbol)};
+  }
+  if(isChoiceGroup(repeated)) {
+    auto groupName = nextChoiceGroupName();
+    addRuleTree(groupName, std::move(repeated));
+    return {.kind = Expr::Kind::symbol, .symbol = addListRule(groupName)};
+  }
+
+// group has no repetitions left so the expander never needs to repeat or factor
+  Expander expander(sequences, 0, {}, {}, arena.resource(), expansionPool());
+  return productionTree(repeatProduction(repeated, expander(repeated)));
+}
+
+ebnftobison::Expr ebnftobison::BisonParam::productionTree(const Production& production) const {
+  Expr expr{.kind = Expr::Kind::choice};
+  expr.children.reserve(production.size());
+  for(auto id: production) {
+    auto& sequence = expr.children.emplace_back(Expr{.kind = Expr::Kind::sequence});
+    for(auto symbol: sequences.symbols(id)) {
+      sequence.children.push_back({.kind = Expr::Kind::symbol, .symbol = symbol});
+    }
+  }
+  return expr;
+}
+
+// size is predicted from the tree before any production is built
+ebnftobison::Production ebnftobison::BisonParam::expandRule(SymbolId ruleName, const Expr& expr, const location& loc) {
+  auto predictedSize = predictSize(expr);
+  predictedSizes[ruleName] = predictedSize;
+
+  auto factorThreshold = options.factorThreshold;
+  auto numPredictedProductions = predictedSize.numProductions + predictedSize.numListProductions;
+  if(auto budget = options.productionBudget; budget > 0 && numPredictedProductions > budget) {
+    ++stats.numRulesOverBudget;
+    if(options.refuseOverBudget) {
+      stringstream s;
+      s << "rule " << symbols.name(ruleName) << " expands to " << numPredictedProductions << " productions, over budget of " << budget;
+      throw EbnfToBison::syntax_error(loc, s.str());
+    }
+    factorThreshold = factorThreshold > 0? min(factorThreshold, budget): budget;
+  }
+
+  Expander expander(sequences, factorThreshold,
+    [this](Production&& production) {
+      return factorProduction(std::move(production));
+    },
+    [this](const Expr& repeated, Production&& production) {
+      return repeatProduction(repeated, std::move(production));
+    },
+    arena.resource(),
+    expansionPool());
+  return expander(expr);
+}
+
+ebnftobison::TaskPool* ebnftobison::BisonParam::expansionPool() {
+  if(options.expandThreads <= 1) {
+    return nullptr;
+  }
+  if(!taskPool) {
+    taskPool = make_unique<TaskPool>(options.expandThreads);
+  }
+  return taskPool.get();
+}
+
+// rules are printed in name order so symbol ids left from earlier conversions don't change any output
+void ebnftobison::BisonParam::clear(bool keepSymbols) {
+  result.clear();
+  ruleTrees.clear();
+  predictedSizes.clear();
+  helperNames.clear();
+  diagnostics.clear();
+  if(!keepSymbols) {
+    symbols.clear();
+    normalizeName.clear();
+  }
+  sequences.clear();
+// result is empty so nothing in the arena is used any more
+  arena.release();
+  stats = {};
+  if(taskPool) {
+    taskPool->resetStats();
+  }
+}
+
+ebnftobison::NamedRule ebnftobison::BisonParam::namedResult() const {
+  NamedRule namedRules;
+  for(const auto& [ruleName, production]: result) {
+    namedRules[symbols.name(ruleName)] = namedProduction(production);
+  }
+  return namedRules;
+}
+
+set<vector<string>> ebnftobison::BisonParam::namedProduction(const Production& production) const {
+  set<vector<string>> names;
+  for(auto id: production) {
+    names.insert(symbols.names(sequences.symbols(id)));
+  }
+  return names;
 }
 
 void ebnftobison::EbnfToBison::error(const location& loc, const string& msg) {
   bisonParam.result.clear();
-  cerr << "error at " << loc << ": " << msg << "\n";
+  bisonParam.ruleTrees.clear();
+  stringstream s;
+  s << "error at " << loc << ": " << msg;
+  bisonParam.diagnostics.push_back(s.str());
 }
 
 }
@@ -177,12 +551,18 @@ void ebnftobison::EbnfToBison::error(const location& loc, const string& msg) {
 // %initial-action codeblock goes inside parse() function in .cpp, it's a separate brace-scoped block, anything declared here is local to this block and cannot be used anywhere else in parse()
 
   bisonParam.stats.parseStartTime = steady_clock::now();
-
+  bisonParam.stats.numRulesGenerated = 0;
+  bisonParam.stats.numProductionsGenerated = 0;
+  bisonParam.stats.numOptionalsFactored = 0;
+  bisonParam.stats.numGroupsFactored = 0;
+  bisonParam.stats.numChoiceGroups = 0;
+  bisonParam.stats.numRulesOverBudget = 0;
+  bisonParam.diagnostics.clear();
+
+// only the name is filled in, a parse can start at a later line of its input
   if(loc.begin.filename == nullptr) {
-    loc.initialize(&defaultInputName);
+    loc.begin.filename = loc.end.filename = &defaultInputName;
   }
-
-  groupNumber = 0;
 }
 
 %token COLON_EQUAL          "::="
@@ -195,89 +575,85 @@ void ebnftobison::EbnfToBison::error(const location& loc, const string& msg) {
 
 %token RULE_SEPARATOR
 
-%token <string> NONTERMINAL
-%token <string> TOKEN
-%token <string> LITERAL
-%token <string> COMMENT
-%token <string> HEADER_LINE
+// token values are views of text owned by the lexer or its input buffer that last for the whole parse
+%token <string_view> NONTERMINAL
+%token <string_view> TOKEN
+%token <string_view> LITERAL
+%token <string_view> COMMENT
+%token <string_view> HEADER_LINE
 
-%nterm <string> element
+%nterm <SymbolId> element
 
-%nterm <Production> production
-%nterm <Production> concatenation
-%nterm <Production> alternative
-%nterm <Production> optional
-%nterm <Production> repetition
+// rule bodies are kept as ebnf trees until the whole rule is parsed
+%nterm <Expr> production
+%nterm <Expr> concatenation
+%nterm <Expr> alternative
+%nterm <Expr> optional
+%nterm <Expr> repetition
 
 %nterm <Combo> group
 %nterm <Combo> production_combo
 
-%nterm <Rule> rule
-%nterm <Rule> rules
-
 %start ebnf
 
 %%
 
 // no code allowed in rules section, just bison comments that are dropped from .cpp
 
-ebnf: header rule {
-  bisonParam.result.merge($rule);
-} postprocess
-| header rule rules {
-  bisonParam.result.merge($rule);
-  bisonParam.result.merge($rules);
-} postprocess
+ebnf: header rule postprocess
+| header rule rules postprocess
 ;
 
-rules: RULE_SEPARATOR rule {
-  $$ = $rule;
-}| rules RULE_SEPARATOR rule {
-  $$ = $1;
-  $$.merge($rule);
-}
+// rules have no semantic value, each one is handed to bisonParam as soon as it's reduced
+rules: RULE_SEPARATOR rule
+| rules RULE_SEPARATOR rule
 ;
 
 rule: NONTERMINAL "::=" production_combo {
   ++bisonParam.stats.numRulesParsed;
-  auto underscoresName = regex_replace($NONTERMINAL.substr(1, $NONTERMINAL.length() - 2), regex{"[^a-zA-Z0-9_]"}, "_");
-  $$ = { {underscoresName, $production_combo.production} };
+  auto ruleName = bisonParam.internNonterminal($NONTERMINAL);
+  auto expr = $production_combo.expr;
+  if(bisonParam.options.keepTrees) {
+    bisonParam.predictedSizes[ruleName] = predictSize(expr);
+    bisonParam.addRuleTree(ruleName, bisonParam.lowerRepetitions(std::move(expr)));
+  } else {
+    bisonParam.addRule(ruleName, bisonParam.expandRule(ruleName, expr, @$));
+  }
 }
 
 production_combo: concatenation {
-  $$ = {.comboType = Combo::Type::concatenation, .production = $concatenation};
+  $$ = {.comboType = Combo::Type::concatenation, .expr = $concatenation};
 }
 | alternative {
-  $$ = {.comboType = Combo::Type::alternative, .production = $alternative};
+  $$ = {.comboType = Combo::Type::alternative, .expr = $alternative};
 }
 | COMMENT {
 }
 ;
 
 concatenation: production {
-  $$ = $production;
+  $$ = {.kind = Expr::Kind::sequence};
+  $$.children.push_back($production);
 }
 | concatenation production {
-  auto i = 0;
-  for(const auto& v: $1) {
-    for(const auto& w: $production) {
-      auto joined = v;
-      joined.insert(joined.end(), w.begin(), w.end());
-      $$.insert(joined);
-      ++i;
-    }
-  }
+  $$ = $1;
+  $$.children.push_back($production);
 }
 ;
 
 alternative: production_combo "|" concatenation {
-  $$ = $production_combo.production;
-  $$.merge($concatenation);
+  auto combo = $production_combo;
+  if(combo.comboType == Combo::Type::alternative) {
+    $$ = std::move(combo.expr);
+  } else {
+    $$ = {.kind = Expr::Kind::choice};
+    $$.children.push_back(std::move(combo.expr));
+  }
+  $$.children.push_back($concatenation);
 }
 
 production: element {
-  $$ = { {$element} };
-
+  $$ = {.kind = Expr::Kind::symbol, .symbol = $element};
 }
 | optional {
   $$ = $optional;
@@ -286,60 +662,41 @@ production: element {
   $$ = $repetition;
 }
 | group {
-  $$ = $group.production;
+  $$ = $group.expr;
 }
 ;
 
 element: NONTERMINAL {
-  $$ = regex_replace($NONTERMINAL.substr(1, $NONTERMINAL.length() - 2), regex{"[^a-zA-Z0-9_]"}, "_");
+  $$ = bisonParam.internNonterminal($NONTERMINAL);
+}
+| TOKEN {
+  $$ = bisonParam.symbols.intern($TOKEN);
+}
+| LITERAL {
+  $$ = bisonParam.symbols.intern($LITERAL);
 }
-| TOKEN | LITERAL | NONTERMINAL COMMENT {
-  $$ = regex_replace($NONTERMINAL.substr(1, $NONTERMINAL.length() - 2), regex{"[^a-zA-Z0-9_]"}, "_");
+| NONTERMINAL COMMENT {
+  $$ = bisonParam.internNonterminal($NONTERMINAL);
+}
+| TOKEN COMMENT {
+  $$ = bisonParam.symbols.intern($TOKEN);
 }
-| TOKEN COMMENT
 ;
 
 optional: "[" production_combo "]" {
-  $$ = $production_combo.production;
-  $$.merge(set<vector<string>>{{}});
+  $$ = {.kind = Expr::Kind::optional};
+  $$.children.push_back($production_combo.expr);
 }
 ;
 
-// replace ellipsis repetition with new left-recursive rule to generate infinite sequences
+// repetitions are replaced by list rules when the rule is expanded
 repetition: element "..." {
-  auto listRuleName = $element + "_list"s;
-// left-recursive list rule for element elt
-// elt_list: elt | elt_list elt
-  bisonParam.result[listRuleName] = { {$element}, {listRuleName, $element} };
-  $$ = { {listRuleName} };
+  $$ = {.kind = Expr::Kind::repetition};
+  $$.children.push_back({.kind = Expr::Kind::symbol, .symbol = $element});
 }
 | group "..." {
-  if($group.comboType == Combo::Type::concatenation) {
-    string listRuleName;
-    for(auto& v: $group.production) {
-      for(auto& e: v) {
-        listRuleName += e + "_";
-      }
-      listRuleName += "list";
-      auto w = v;
-      w.insert(w.begin(), listRuleName);
-      bisonParam.result[listRuleName] = { v, w };
-      $$.insert({listRuleName});
-    }
-  } else {
-// groups are replaced by new single nonterminal
-// move all productions of group to new rule for new nonterminal
-    stringstream s;
-    s << "choice_group_" << groupNumber;
-    string groupName = s.str();
-    ++groupNumber;
-    bisonParam.result[groupName] = $group.production;
-    $group.production = { {groupName} };
-
-    auto listRuleName = groupName + "_list";
-    bisonParam.result[listRuleName] = { {groupName}, {listRuleName, groupName} };
-    $$ = { {listRuleName} };
-  }
+  $$ = {.kind = Expr::Kind::repetition};
+  $$.children.push_back($group.expr);
 }
 | optional "..." {
 }
@@ -360,137 +717,14 @@ postprocess: %empty {
   auto& stats = b.stats;
   stats.parseEndTime = steady_clock::now();
   stats.parseTimeTakenSec = stats.parseEndTime - stats.parseStartTime;
-  stats.numRulesGenerated = b.result.size();
+  if(b.taskPool) {
+    const auto& poolStats = b.taskPool->stats();
+    stats.numExpandTasks = poolStats.numTasks;
+    stats.numExpandTasksStolen = poolStats.numTasksStolen;
+    stats.expandTaskTime = poolStats.taskTime;
+    stats.maxExpandTaskTime = poolStats.maxTaskTime;
+  }
 }
 
 %%
 
-#ifdef BUILD_MAIN
-
-#include <stdlib.h>
-#include <stdio.h>
-#include <getopt.h>
-
-#include <string>
-#include <iostream>
-#include <memory>
-#include <istream>
-#include <fstream>
-
-#include "lexer/ebnftobison_lexer.h"
-#include "ebnftobison.bison.h"
-
-using namespace std;
-using namespace ebnftobison;
-
-void usage() {
-  puts("Usage: ebnftobison [-h | --help] [--debug] [file]");
-  puts("ebnftobison converts extended EBNF as defined in Section 5.2 of the GQL ISO-39075:2024 standard to a Bison grammar");
-  puts("");
-  puts("Options:");
-  puts("--debug: turns on Bison parser and Flex lexer debug traces, off by default");
-  puts("--stats: print timing stats on successful parse, off by default");
-  puts("--help | -h: prints usage help");
-  puts("file: extended EBNF grammar file");
-}
-
-int main(int argc, char* argv[])
-{
-  ios_base::sync_with_stdio(false);
-
-  bool debug{};
-  bool printStats{};
-
-// need filename pointer to stick around for bison error messages that print filename and position
-  auto inputFilename = make_unique<string>("stdin");
-  string changefile;
-
-  option opts[] = {
-    {"debug", no_argument, (int*)&debug, 1},
-    {"stats", no_argument, (int*)&printStats, 1},
-    {"help", no_argument, 0, 'h'},
-    {0, 0, 0, 0}
-  };
-
-  for(int i, optLetter; (optLetter = getopt_long(argc, argv, "h", opts, &i)) != -1;) {
-    switch(optLetter) {
-    case 0:
-      break;
-    case 'h':
-      usage();
-      return 0;
-    case '?':
-      usage();
-      return 1;
-    default:
-      break;
-    }
-  }
-
-  Lexer lexer;
-
-// set filename for bison error reporting
-// switch input stream for lexer to read from file instead of default stdin
-  ifstream fileStream;
-  if(optind < argc) {
-    *inputFilename = argv[optind];
-    if(fileStream.open(*inputFilename); !fileStream) {
-      fprintf(stderr, "error opening file \"%s\"\n", inputFilename->c_str());
-      exit(1);
-    }
-    lexer.switch_streams(&fileStream);
-  }
-
-  location loc(inputFilename.get());
-  BisonParam bisonParam;
-
-  EbnfToBison parser([&lexer](location& loc) -> EbnfToBison::symbol_type {
-    return lexer.yylex(loc);
-  },
-  bisonParam,
-  loc);
-
-  lexer.set_debug(debug);
-  parser.set_debug_level(debug);
-
-  if(auto ev = parser(); ev != 0) {
-    fputs("parse failed\n", stderr);
-    return ev;
-  }
-
-  if(printStats) {
-    const auto& stats = bisonParam.stats;
-
-    printf("parse_time %.9f secs, num_rules_parsed %lu, num_rules_generated %lu\n", stats.parseTimeTakenSec.count(), stats.numRulesParsed, stats.numRulesGenerated);
-  }
-
-  puts("");
-  puts("result:");
-  for(const auto& [rule, productions]: bisonParam.result) {
-    printf("# %zu productions\n", productions.size());
-    printf("%s:\n", rule.c_str());
-    if(productions.empty()) {
-      puts("");
-      continue;
-    }
-    const auto& firstProduction = *productions.begin();
-    for(const auto& elt: firstProduction) {
-      printf("  %s", elt.c_str());
-    }
-    puts("");
-    auto i = productions.begin();
-    for(++i; i != productions.end(); ++i) {
-      const auto& production = *i;
-      printf("|");
-      for(const auto& elt: production) {
-        printf("  %s", elt.c_str());
-      }
-      puts("");
-    }
-    puts("");
-  }
-  
-  return 0;
-}
-
-#endif
@@ -0,0 +1,143 @@
+// ebnftobison_lexer.bench.cpp
+
+/*
+MIT License
+
+Copyright (c) 2024 Zartaj Majeed
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <string_view>
+
+#include <getopt.h>
+
+#include "ebnftobison_lexer.h"
+#include "ebnftobison_simd_lexer.h"
+#include "ebnftobison_mapped_file.h"
+#include "ebnftobison.bison.h"
+
+using namespace std;
+using namespace ebnftobison;
+
+namespace {
+
+// lexer microbenchmark, scans a whole grammar file repeatedly and reports tokens per second for each lexer
+
+struct Result {
+  uint64_t numTokens = 0;
+  double secs = 0;
+  bool failed = false;
+};
+
+// scan buffer to end of input or first lexer error
+template<typename L>
+uint64_t scan(L& lexer, string_view contents, bool& failed) {
+  lexer.switch_buffer(contents);
+  location loc{};
+  uint64_t numTokens = 0;
+  try {
+    while(lexer.yylex(loc).kind() != EbnfToBison::symbol_kind::S_YYEOF) {
+      ++numTokens;
+    }
+  } catch(const EbnfToBison::syntax_error&) {
+    failed = true;
+  }
+  return numTokens;
+}
+
+template<typename L>
+Result run(L& lexer, string_view contents, int iterations) {
+  Result result;
+  auto startTime = chrono::steady_clock::now();
+  for(int i = 0; i < iterations; ++i) {
+    result.numTokens += scan(lexer, contents, result.failed);
+  }
+  auto endTime = chrono::steady_clock::now();
+  result.secs = chrono::duration<double>(endTime - startTime).count();
+  return result;
+}
+
+void report(const char* name, const Result& result) {
+  printf("%-5s %lu tokens in %.6f secs, %.0f tokens/sec%s\n", name, result.numTokens, result.secs, result.numTokens / result.secs, result.failed? " (stopped at lexer error)": "");
+}
+
+void usage() {
+  puts("usage: ebnftobison_lexer.bench [-i iterations] [grammar_file]");
+  puts("scan grammar_file with the flex and simd lexers and report tokens per second");
+  puts("-i, --iterations: number of scans of the file per lexer, default 20");
+  puts("grammar_file: defaults to docs/gqlgrammar.quotedliterals.txt");
+  puts("-h, --help: print this help");
+}
+
+}
+
+int main(int argc, char* argv[]) {
+
+  int iterations = 20;
+  string inputFile = EBNFTOBISON_DOCS_DIR "/gqlgrammar.quotedliterals.txt";
+
+  option longOptions[] = {
+    {"iterations", required_argument, nullptr, 'i'},
+    {"help", no_argument, nullptr, 'h'},
+    {}
+  };
+
+  for(int opt; (opt = getopt_long(argc, argv, "i:h", longOptions, nullptr)) != -1;) {
+    switch(opt) {
+    case 'i':
+      iterations = atoi(optarg);
+      break;
+    case 'h':
+      usage();
+      exit(0);
+    default:
+      usage();
+      exit(1);
+    }
+  }
+
+  if(optind < argc) {
+    inputFile = argv[optind];
+  }
+
+  if(iterations < 1) {
+    fprintf(stderr, "iterations must be at least 1\n");
+    exit(1);
+  }
+
+  MappedFile mappedFile;
+  if(!mappedFile.open(inputFile)) {
+    fprintf(stderr, "could not map %s\n", inputFile.c_str());
+    exit(1);
+  }
+  auto contents = mappedFile.contents();
+
+  printf("%s: %zu bytes, %d iterations\n", inputFile.c_str(), contents.size(), iterations);
+
+  Lexer lexer;
+  report("flex", run(lexer, contents, iterations));
+
+  SimdLexer simdLexer;
+  report("simd", run(simdLexer, contents, iterations));
+}
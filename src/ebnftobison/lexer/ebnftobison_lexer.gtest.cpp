@@ -25,14 +25,23 @@ SOFTWARE.
 */
 
 
+#include <functional>
 #include <iostream>
+#include <memory>
+#include <optional>
 #include <sstream>
 #include <string>
+#include <string_view>
+#include <thread>
+#include <tuple>
+#include <vector>
 
 #include <gtest/gtest.h>
 
 #include "ebnftobison_lexer.h"
 #include "ebnftobison.bison.h"
+#include "ebnftobison_spsc_ring.h"
+#include "ebnftobison_pipelined_lexer.h"
 
 using namespace std;
 using namespace ::testing;
@@ -51,6 +60,118 @@ TEST(Lexer, test_0) {
   EXPECT_EQ(token.kind(), EbnfToBison::symbol_kind::S_NONTERMINAL);
 }
 
+TEST(Lexer, test_1) {
+
+  string_view input = "<true literal> ::= TRUE | \"true\"";
+  Lexer lexer;
+  lexer.switch_buffer(input);
+
+  location loc{};
+
+  auto nonterminal = lexer.yylex(loc);
+  ASSERT_EQ(nonterminal.kind(), EbnfToBison::symbol_kind::S_NONTERMINAL);
+  EXPECT_EQ(nonterminal.value.as<string_view>(), "<true literal>");
+// token value is a view into the input buffer, not a copy
+  EXPECT_EQ(nonterminal.value.as<string_view>().data(), input.data());
+
+  EXPECT_EQ(lexer.yylex(loc).kind(), EbnfToBison::symbol_kind::S_COLON_EQUAL);
+
+  auto token = lexer.yylex(loc);
+  ASSERT_EQ(token.kind(), EbnfToBison::symbol_kind::S_TOKEN);
+  EXPECT_EQ(token.value.as<string_view>(), "TRUE");
+  EXPECT_EQ(token.value.as<string_view>().data(), input.data() + input.find("TRUE"));
+
+  EXPECT_EQ(lexer.yylex(loc).kind(), EbnfToBison::symbol_kind::S_BAR);
+
+  auto literal = lexer.yylex(loc);
+  ASSERT_EQ(literal.kind(), EbnfToBison::symbol_kind::S_LITERAL);
+  EXPECT_EQ(literal.value.as<string_view>(), "\"true\"");
+
+  EXPECT_EQ(lexer.yylex(loc).kind(), EbnfToBison::symbol_kind::S_YYEOF);
 }
 
+TEST(SpscRing, test_0) {
+
+// ring much smaller than what goes through it, both sides have to wait on each other
+  SpscRing<unique_ptr<int>> ring(4);
+  EXPECT_EQ(ring.capacity(), 4);
+
+  const int n = 100000;
+  thread producer([&ring] {
+    for(int i = 0; i < n; ++i) {
+      auto value = make_unique<int>(i);
+      while(!ring.tryPush(value)) {
+        ring.waitForRoom();
+      }
+    }
+  });
+
+  vector<int> popped;
+  for(optional<unique_ptr<int>> value; popped.size() < n;) {
+    if(!ring.tryPop(value)) {
+      ring.waitForItem();
+      continue;
+    }
+    popped.push_back(**value);
+  }
+  producer.join();
+
+  ASSERT_EQ(popped.size(), n);
+  for(int i = 0; i < n; ++i) {
+    ASSERT_EQ(popped[i], i);
+  }
+
+// a closed ring wakes the other side for good
+  ring.close();
+  EXPECT_FALSE(ring.waitForItem());
+}
 
+TEST(Lexer, test_2) {
+
+  string input;
+  for(int i = 0; i < 500; ++i) {
+    input += "<rule " + to_string(i) + "> ::= TOKEN [ <other> ] | \"literal\" {x}...\n";
+  }
+  input += "<bad> ::= $\n";
+
+// locations are compared as printed
+  auto tokens = [](function<EbnfToBison::symbol_type(location&)> yylex) {
+    auto where = [](const location& loc) { stringstream s; s << loc; return s.str(); };
+    vector<tuple<int, string, string>> v;
+    location loc{};
+    try {
+      for(;;) {
+        auto token = yylex(loc);
+        auto kind = token.kind();
+        string value;
+        if(kind == EbnfToBison::symbol_kind::S_NONTERMINAL || kind == EbnfToBison::symbol_kind::S_TOKEN || kind == EbnfToBison::symbol_kind::S_LITERAL) {
+          value = token.value.as<string_view>();
+        }
+        v.emplace_back(kind, value, where(loc));
+        if(kind == EbnfToBison::symbol_kind::S_YYEOF) {
+          break;
+        }
+      }
+    } catch(const EbnfToBison::syntax_error& e) {
+      v.emplace_back(-1, e.what(), where(e.location));
+    }
+    return v;
+  };
+
+  Lexer lexer;
+  lexer.switch_buffer(input);
+  auto expected = tokens([&lexer](location& loc) { return lexer.yylex(loc); });
+  ASSERT_GT(expected.size(), 5000);
+  EXPECT_EQ(get<0>(expected.back()), -1);
+
+// same tokens, locations and error through a ring of 8
+  Lexer aheadLexer;
+  aheadLexer.switch_buffer(input);
+  PipelinedLexer pipelined([&aheadLexer](location& loc) { return aheadLexer.yylex(loc); }, 8);
+  EXPECT_EQ(tokens([&pipelined](location& loc) { return pipelined.yylex(loc); }), expected);
+
+  pipelined.stop();
+  EXPECT_EQ(pipelined.stats().numTokens, expected.size() - 1);
+}
+
+}
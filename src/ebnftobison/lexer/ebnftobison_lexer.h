@@ -26,7 +26,13 @@ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 SOFTWARE.
 */
 
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
 #include "ebnftobison.bison.h"
+#include "lexer/ebnftobison_pending_tokens.h"
 
 #include "ebnftobison_guard_flexlexer.h"
 
@@ -45,11 +51,53 @@ public:
 
   explicit Lexer(istream* yyin_arg): yyFlexLexer(yyin_arg) {}
 
+// scan in place from a buffer that outlives the parse, eg a memory mapped file
+// token values are views into the buffer so no token text is copied
+  void switch_buffer(string_view buffer);
+
+// scan from a stream, like switch_buffer this starts over in the header so a lexer can be reused for another grammar
+  void switch_streams(istream* new_in = nullptr, ostream* new_out = nullptr) override;
+
+// the reference overload is not changed
+  using yyFlexLexer::switch_streams;
+
 private:
 
 // fix gcc-13 warning -Woverloaded-virtual that virtual int EbnfToBison::yylex() was hidden
   using yyFlexLexer::yylex;
-  
+
+// flex reads through here, serves input from the buffer if there is one otherwise from the input stream
+  int LexerInput(char* buf, int max_size) override;
+
+// view of the current token that stays valid for the whole parse
+  string_view tokenText();
+  string_view tokenText(size_t length);
+
+// view of input from offset start to end of current token when scanning a buffer, otherwise a kept copy of text
+  string_view spanText(size_t start, string_view text);
+
+// copies text into storage owned by the lexer for tokens scanned from a stream
+  string_view keep(string_view text);
+
+// tokens matched together with a rule separator
+  PendingTokens pendingTokens;
+
+// columns matched as part of a token that count toward location of next token
+  int pendingColumns = 0;
+
+  string_view buffer;
+  bool scanningBuffer = false;
+  size_t bufferReadOffset = 0;
+
+// offsets of current token and end of all matched input, kept up to date by YY_USER_ACTION
+  size_t tokenOffset = 0;
+  size_t scannedOffset = 0;
+
+// blocks of token text copied from stream input
+  vector<unique_ptr<char[]>> textBlocks;
+  char* textBlockPos = nullptr;
+  size_t textBlockLeft = 0;
+
 };
 
 }
@@ -0,0 +1,122 @@
+#ifndef EBNFTOBISON_MAPPED_FILE_H
+#define EBNFTOBISON_MAPPED_FILE_H
+// ebnftobison_mapped_file.h
+
+/*
+MIT License
+
+Copyright (c) 2024 Zartaj Majeed
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <string>
+#include <string_view>
+#include <utility>
+
+namespace ebnftobison {
+using namespace std;
+
+// read-only memory mapping of a whole file so the lexer can scan it in place
+// only regular files can be mapped, open fails for anything else like pipes and the caller should fall back to a stream
+class MappedFile {
+public:
+
+  MappedFile() = default;
+
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  MappedFile(MappedFile&& other) noexcept:
+    data(exchange(other.data, nullptr)),
+    length(exchange(other.length, 0)),
+    isOpen(exchange(other.isOpen, false)) {}
+
+  MappedFile& operator=(MappedFile&& other) noexcept {
+    swap(data, other.data);
+    swap(length, other.length);
+    swap(isOpen, other.isOpen);
+    return *this;
+  }
+
+  ~MappedFile() {
+    close();
+  }
+
+  bool open(const string& filename) {
+    close();
+
+    auto fd = ::open(filename.c_str(), O_RDONLY | O_CLOEXEC);
+    if(fd == -1) {
+      return false;
+    }
+
+    struct stat st;
+    if(fstat(fd, &st) == -1 || !S_ISREG(st.st_mode)) {
+      ::close(fd);
+      return false;
+    }
+
+// mmap cannot map zero bytes, an empty file is just an empty view
+    if(st.st_size > 0) {
+      auto p = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if(p == MAP_FAILED) {
+        ::close(fd);
+        return false;
+      }
+      madvise(p, st.st_size, MADV_SEQUENTIAL);
+      data = static_cast<const char*>(p);
+      length = st.st_size;
+    }
+
+// mapping stays valid after descriptor is closed
+    ::close(fd);
+    isOpen = true;
+    return true;
+  }
+
+  void close() {
+    if(data != nullptr) {
+      munmap(const_cast<char*>(data), length);
+    }
+    data = nullptr;
+    length = 0;
+    isOpen = false;
+  }
+
+  explicit operator bool() const { return isOpen; }
+
+  string_view contents() const { return {data, length}; }
+
+private:
+
+  const char* data = nullptr;
+  size_t length = 0;
+  bool isOpen = false;
+
+};
+
+}
+
+#endif
@@ -0,0 +1,70 @@
+#ifndef EBNFTOBISON_PENDING_TOKENS_H
+#define EBNFTOBISON_PENDING_TOKENS_H
+// ebnftobison_pending_tokens.h
+
+/*
+MIT License
+
+Copyright (c) 2024 Zartaj Majeed
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <deque>
+#include <utility>
+
+#include "ebnftobison.bison.h"
+
+namespace ebnftobison {
+using namespace std;
+
+// tokens matched together with a rule separator, returned one per call with location advanced by columns
+// shared by the flex lexer and the simd lexer so both give rule starts the same locations
+class PendingTokens {
+public:
+
+  void push(EbnfToBison::symbol_type&& token, int columns) {
+    tokens.push_back({std::move(token), columns});
+  }
+
+  bool empty() const { return tokens.empty(); }
+
+  void clear() { tokens.clear(); }
+
+  EbnfToBison::symbol_type pop(location& loc) {
+    auto [token, columns] = std::move(tokens.front());
+    tokens.pop_front();
+    loc.columns(columns);
+    token.location = loc;
+    return std::move(token);
+  }
+
+private:
+
+  struct PendingToken {
+    EbnfToBison::symbol_type token;
+    int columns;
+  };
+  deque<PendingToken> tokens;
+
+};
+
+}
+
+#endif
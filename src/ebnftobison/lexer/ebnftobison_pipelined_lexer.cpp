@@ -0,0 +1,93 @@
+// ebnftobison_pipelined_lexer.cpp
+
+/*
+MIT License
+
+Copyright (c) 2024 Zartaj Majeed
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "ebnftobison_pipelined_lexer.h"
+
+namespace ebnftobison {
+
+EbnfToBison::symbol_type PipelinedLexer::yylex(location& loc) {
+  if(finished) {
+    return EbnfToBison::make_YYEOF(loc);
+  }
+// lexer thread carries on from where the parser's location starts
+  if(!lexerThread.joinable()) {
+    lexerThread = jthread([this, loc] { produce(loc); });
+  }
+
+  optional<Entry> entry;
+  if(!ring.tryPop(entry)) {
+    auto startTime = steady_clock::now();
+    auto hasItem = ring.waitForItem();
+    lexerStats.parserStallTime += steady_clock::now() - startTime;
+    if(!hasItem) {
+      finished = true;
+      return EbnfToBison::make_YYEOF(loc);
+    }
+    ring.tryPop(entry);
+  }
+
+  if(entry->error) {
+    finished = true;
+    rethrow_exception(entry->error);
+  }
+  ++lexerStats.numTokens;
+  finished = entry->token.kind() == EbnfToBison::symbol_kind::S_YYEOF;
+  loc = entry->token.location;
+  return std::move(entry->token);
+}
+
+// ends after pushing the end of input or the first error, same as the parser never asks past either
+void PipelinedLexer::produce(location loc) {
+  for(bool last = false; !last;) {
+    optional<Entry> entry;
+    try {
+      entry.emplace(lex(loc));
+      last = entry->token.kind() == EbnfToBison::symbol_kind::S_YYEOF;
+    } catch(...) {
+      entry.emplace(EbnfToBison::make_YYEOF(loc), current_exception());
+      last = true;
+    }
+    if(!ring.tryPush(*entry)) {
+      auto startTime = steady_clock::now();
+      auto hasRoom = ring.waitForRoom();
+      lexerStallTime += steady_clock::now() - startTime;
+      if(!hasRoom) {
+        return;
+      }
+      ring.tryPush(*entry);
+    }
+  }
+}
+
+void PipelinedLexer::stop() {
+  if(lexerThread.joinable()) {
+    ring.close();
+    lexerThread.join();
+    lexerStats.lexerStallTime = lexerStallTime;
+  }
+}
+
+}
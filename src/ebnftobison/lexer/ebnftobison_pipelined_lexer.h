@@ -0,0 +1,97 @@
+#ifndef EBNFTOBISON_PIPELINED_LEXER_H
+#define EBNFTOBISON_PIPELINED_LEXER_H
+// ebnftobison_pipelined_lexer.h
+
+/*
+MIT License
+
+Copyright (c) 2024 Zartaj Majeed
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <chrono>
+#include <exception>
+#include <functional>
+#include <optional>
+#include <thread>
+
+#include "ebnftobison.bison.h"
+#include "ebnftobison_spsc_ring.h"
+
+namespace ebnftobison {
+using namespace std;
+using namespace chrono;
+
+// runs a lexer on its own thread ahead of the parser and hands tokens over through an SpscRing
+// reading and scanning input then overlaps with the parser's actions
+// the lexer must keep token values valid for the whole parse, both Lexer and SimdLexer do
+class PipelinedLexer {
+public:
+
+  using Yylex = function<EbnfToBison::symbol_type(location&)>;
+
+  struct Stats {
+    uint64_t numTokens = 0;
+// time the lexer thread waited for room in a full ring
+    duration<double> lexerStallTime{};
+// time the parser waited for a token from an empty ring
+    duration<double> parserStallTime{};
+  };
+
+// the lexer thread starts with the first token asked for, so the lexer can still be set up after this
+  PipelinedLexer(Yylex yylex, size_t capacity = 1024): lex(std::move(yylex)), ring(capacity) {}
+
+  PipelinedLexer(const PipelinedLexer&) = delete;
+  PipelinedLexer& operator=(const PipelinedLexer&) = delete;
+
+  ~PipelinedLexer() { stop(); }
+
+// next token with loc set to its location, an error thrown by the lexer is rethrown here in token order
+  EbnfToBison::symbol_type yylex(location& loc);
+
+// stops the lexer thread if it is still running and waits for it
+  void stop();
+
+// complete once stop has been called
+  const Stats& stats() const { return lexerStats; }
+
+private:
+
+  struct Entry {
+    EbnfToBison::symbol_type token;
+// token is only a placeholder when set
+    exception_ptr error{};
+  };
+
+  void produce(location loc);
+
+  Yylex lex;
+  SpscRing<Entry> ring;
+  jthread lexerThread;
+// set when the end of input or an error has been popped, nothing more will come
+  bool finished = false;
+  Stats lexerStats;
+  duration<double> lexerStallTime{};
+
+};
+
+}
+
+#endif
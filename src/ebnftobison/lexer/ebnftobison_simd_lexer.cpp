@@ -0,0 +1,344 @@
+// ebnftobison_simd_lexer.cpp
+
+/*
+MIT License
+
+Copyright (c) 2024 Zartaj Majeed
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <iterator>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "lexer/ebnftobison_simd_lexer.h"
+
+using namespace std;
+
+using namespace ebnftobison;
+
+using symbol_type = EbnfToBison::symbol_type;
+
+namespace {
+
+#if defined(__AVX2__)
+
+#define EBNFTOBISON_SIMD_BLOCKS 1
+using Block = __m256i;
+constexpr ptrdiff_t blockSize = 32;
+inline Block load(const char* p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)); }
+inline Block splat(char c) { return _mm256_set1_epi8(c); }
+inline Block eq(Block a, Block b) { return _mm256_cmpeq_epi8(a, b); }
+inline Block gt(Block a, Block b) { return _mm256_cmpgt_epi8(a, b); }
+inline Block bitOr(Block a, Block b) { return _mm256_or_si256(a, b); }
+inline Block bitAnd(Block a, Block b) { return _mm256_and_si256(a, b); }
+inline Block andNot(Block a, Block b) { return _mm256_andnot_si256(a, b); }
+inline uint32_t byteMask(Block a) { return static_cast<uint32_t>(_mm256_movemask_epi8(a)); }
+constexpr uint32_t fullMask = 0xffffffff;
+
+#elif defined(__SSE2__)
+
+#define EBNFTOBISON_SIMD_BLOCKS 1
+using Block = __m128i;
+constexpr ptrdiff_t blockSize = 16;
+inline Block load(const char* p) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)); }
+inline Block splat(char c) { return _mm_set1_epi8(c); }
+inline Block eq(Block a, Block b) { return _mm_cmpeq_epi8(a, b); }
+inline Block gt(Block a, Block b) { return _mm_cmpgt_epi8(a, b); }
+inline Block bitOr(Block a, Block b) { return _mm_or_si128(a, b); }
+inline Block bitAnd(Block a, Block b) { return _mm_and_si128(a, b); }
+inline Block andNot(Block a, Block b) { return _mm_andnot_si128(a, b); }
+inline uint32_t byteMask(Block a) { return static_cast<uint32_t>(_mm_movemask_epi8(a)); }
+constexpr uint32_t fullMask = 0xffff;
+
+#endif
+
+#ifdef EBNFTOBISON_SIMD_BLOCKS
+// compares are signed, bytes >= 0x80 are negative so never fall in an ascii range
+inline Block inRange(Block v, char lo, char hi) {
+  return bitAnd(gt(v, splat(lo - 1)), gt(splat(hi + 1), v));
+}
+#endif
+
+// byte classes of the flex patterns, each has a scalar test and a block test that sets matching bytes to 0xff
+
+// [[:space:]]{-}[\n]
+struct SpaceBytes {
+  static bool byte(unsigned char c) { return c == ' ' || (c >= '\t' && c <= '\r' && c != '\n'); }
+#ifdef EBNFTOBISON_SIMD_BLOCKS
+  static Block block(Block v) { return bitOr(eq(v, splat(' ')), andNot(eq(v, splat('\n')), inRange(v, '\t', '\r'))); }
+#endif
+};
+
+// [A-Za-z0-9_]
+struct TokenBytes {
+  static bool byte(unsigned char c) { return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_'; }
+#ifdef EBNFTOBISON_SIMD_BLOCKS
+// or-ing 0x20 folds upper case letters to lower case without bringing in any other byte
+  static Block block(Block v) { return bitOr(bitOr(inRange(bitOr(v, splat(0x20)), 'a', 'z'), inRange(v, '0', '9')), eq(v, splat('_'))); }
+#endif
+};
+
+// [-A-Za-z0-9 _/]
+struct NonterminalBytes {
+  static bool byte(unsigned char c) { return TokenBytes::byte(c) || c == '-' || c == ' ' || c == '/'; }
+#ifdef EBNFTOBISON_SIMD_BLOCKS
+  static Block block(Block v) { return bitOr(TokenBytes::block(v), bitOr(bitOr(eq(v, splat('-')), eq(v, splat(' '))), eq(v, splat('/')))); }
+#endif
+};
+
+// length of run of bytes in class starting at p
+template<typename ByteClass>
+size_t run(const char* p, const char* end) {
+  auto start = p;
+#ifdef EBNFTOBISON_SIMD_BLOCKS
+  for(; end - p >= blockSize; p += blockSize) {
+    if(auto misses = ~byteMask(ByteClass::block(load(p))) & fullMask; misses != 0) {
+      return p - start + countr_zero(misses);
+    }
+  }
+#endif
+  while(p != end && ByteClass::byte(*p)) {
+    ++p;
+  }
+  return p - start;
+}
+
+// "<"[-A-Za-z0-9 _/]+">"
+size_t nonterminalLength(const char* p, const char* end) {
+  if(p == end || *p != '<') {
+    return 0;
+  }
+  auto n = run<NonterminalBytes>(p + 1, end);
+  if(n == 0 || p + 1 + n == end || p[1 + n] != '>') {
+    return 0;
+  }
+  return n + 2;
+}
+
+// (?x: ["] ( [^"\n] | \\["] | \\\\ )* ["] )
+// simulates the pattern nfa to get the same longest match as flex, a backslash before a quote can either escape it or end the literal
+size_t literalLength(const char* p, const char* end) {
+  if(p == end || *p != '"') {
+    return 0;
+  }
+  size_t longest = 0;
+  auto inside = true;
+  auto afterBackslash = false;
+  for(auto q = p + 1; q != end && (inside || afterBackslash); ++q) {
+    auto c = *q;
+    auto nextInside = (inside && c != '"' && c != '\n') || (afterBackslash && c == '"');
+    auto nextAfterBackslash = inside && c == '\\';
+    if(inside && c == '"') {
+      longest = q + 1 - p;
+    }
+    inside = nextInside;
+    afterBackslash = nextAfterBackslash;
+  }
+  return longest;
+}
+
+const char* lineEnd(const char* p, const char* end) {
+  auto q = static_cast<const char*>(memchr(p, '\n', end - p));
+  return q == nullptr? end: q;
+}
+
+}
+
+void SimdLexer::switch_buffer(string_view buffer) {
+  input = buffer;
+  pos = 0;
+  state = State::header;
+  pendingTokens.clear();
+}
+
+void SimdLexer::switch_streams(istream* in) {
+  streamContents.assign(istreambuf_iterator<char>(*in), istreambuf_iterator<char>());
+  switch_buffer(streamContents);
+}
+
+symbol_type SimdLexer::yylex(location& loc) {
+  auto token = state == State::header? scanHeader(loc): scanRules(loc);
+  if(debug) {
+    cerr << "--simd lexer token " << token.name() << " at " << loc << "\n";
+  }
+  return token;
+}
+
+void SimdLexer::badInput(location& loc) {
+  auto c = input[pos++];
+  loc.columns(1);
+  throw EbnfToBison::syntax_error(loc, "bad input \""s + c + "\""s);
+}
+
+// everything above first rule is header, sent line by line
+// first rule of grammar is assumed to start at beginning of line
+symbol_type SimdLexer::scanHeader(location& loc) {
+  loc.step();
+
+  auto begin = input.data();
+  auto end = begin + input.size();
+  auto p = begin + pos;
+
+  if(p == end) {
+    return symbol_type(EbnfToBison::token::YYEOF, loc);
+  }
+
+  if(auto n = nonterminalLength(p, end); n != 0) {
+    state = State::rules;
+    pos += n;
+    loc.columns(n);
+    return EbnfToBison::make_NONTERMINAL(input.substr(p - begin, n), loc);
+  }
+
+  auto q = lineEnd(p, end);
+  loc.columns(q - p);
+// flex drops last header line if it has no newline
+  if(q == end) {
+    pos = input.size();
+    return symbol_type(EbnfToBison::token::YYEOF, loc);
+  }
+  loc.lines();
+  pos = q + 1 - begin;
+  return EbnfToBison::make_HEADER_LINE(input.substr(p - begin, q + 1 - p), loc);
+}
+
+symbol_type SimdLexer::scanRules(location& loc) {
+  loc.step();
+
+// send tokens queued by an earlier match before scanning any more input
+  if(!pendingTokens.empty()) {
+    return pendingTokens.pop(loc);
+  }
+
+  auto begin = input.data();
+  auto end = begin + input.size();
+
+  for(;;) {
+    auto p = begin + pos;
+
+    if(p == end) {
+      return symbol_type(EbnfToBison::token::YYEOF, loc);
+    }
+
+    auto token = [&](size_t n) {
+      pos += n;
+      loc.columns(n);
+      return input.substr(pos - n, n);
+    };
+
+    switch(*p) {
+    case '\n':
+      ++pos;
+      loc.lines(1);
+      continue;
+
+    case ' ': case '\t': case '\v': case '\f': case '\r': {
+      auto n = run<SpaceBytes>(p, end);
+      pos += n;
+      loc.columns(n);
+      continue;
+    }
+
+    case '<': {
+      auto n = nonterminalLength(p, end);
+      if(n == 0) {
+        badInput(loc);
+      }
+// start of rule marks end of previous rule
+// one match gives rule separator, nonterminal and ::= tokens, last two are queued for the next calls
+      auto q = p + n;
+      while(q != end && *q == ' ') {
+        ++q;
+      }
+      if(end - q >= 3 && memcmp(q, "::=", 3) == 0) {
+        auto ruleStartLength = q + 3 - p;
+        pendingTokens.push(EbnfToBison::make_NONTERMINAL(input.substr(pos, n), loc), n);
+        pendingTokens.push(EbnfToBison::make_COLON_EQUAL(loc), ruleStartLength - n);
+        pos += ruleStartLength;
+        return EbnfToBison::make_RULE_SEPARATOR(loc);
+      }
+      return EbnfToBison::make_NONTERMINAL(token(n), loc);
+    }
+
+    case ':':
+      if(end - p >= 3 && memcmp(p, "::=", 3) == 0) {
+        token(3);
+        return EbnfToBison::make_COLON_EQUAL(loc);
+      }
+      badInput(loc);
+
+    case '"': {
+      auto n = literalLength(p, end);
+      if(n == 0) {
+        badInput(loc);
+      }
+      return EbnfToBison::make_LITERAL(token(n), loc);
+    }
+
+    case '|':
+      token(1);
+      return EbnfToBison::make_BAR(loc);
+
+    case '[':
+      token(1);
+      return EbnfToBison::make_LEFT_BRACKET(loc);
+
+    case ']':
+      token(1);
+      return EbnfToBison::make_RIGHT_BRACKET(loc);
+
+    case '{':
+      token(1);
+      return EbnfToBison::make_LEFT_BRACE(loc);
+
+    case '}':
+      token(1);
+      return EbnfToBison::make_RIGHT_BRACE(loc);
+
+    case '.':
+      if(end - p >= 3 && memcmp(p, "...", 3) == 0) {
+        token(3);
+        return EbnfToBison::make_ELLIPSIS(loc);
+      }
+      badInput(loc);
+
+    case '!':
+      if(end - p >= 2 && p[1] == '!') {
+        return EbnfToBison::make_COMMENT(token(lineEnd(p, end) - p), loc);
+      }
+      badInput(loc);
+
+    default:
+      if(auto n = run<TokenBytes>(p, end); n != 0) {
+        return EbnfToBison::make_TOKEN(token(n), loc);
+      }
+      badInput(loc);
+    }
+  }
+}
@@ -0,0 +1,160 @@
+// ebnftobison_simd_lexer.gtest.cpp
+
+/*
+MIT License
+
+Copyright (c) 2024 Zartaj Majeed
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include "ebnftobison_lexer.h"
+#include "ebnftobison_simd_lexer.h"
+#include "ebnftobison_mapped_file.h"
+#include "ebnftobison.bison.h"
+
+using namespace std;
+using namespace ::testing;
+
+namespace ebnftobison::testing {
+
+namespace {
+
+// one printable line per token with kind, location and value, or the error that stopped the lexer
+template<typename L>
+vector<string> tokenStream(L& lexer) {
+  vector<string> tokens;
+  location loc{};
+  try {
+    for(;;) {
+      auto token = lexer.yylex(loc);
+      stringstream s;
+      s << token.name() << " " << token.location;
+      switch(token.kind()) {
+      case EbnfToBison::symbol_kind::S_NONTERMINAL:
+      case EbnfToBison::symbol_kind::S_TOKEN:
+      case EbnfToBison::symbol_kind::S_LITERAL:
+      case EbnfToBison::symbol_kind::S_COMMENT:
+      case EbnfToBison::symbol_kind::S_HEADER_LINE:
+        s << " [" << token.value.template as<string_view>() << "]";
+        break;
+      default:
+        break;
+      }
+      tokens.push_back(s.str());
+      if(token.kind() == EbnfToBison::symbol_kind::S_YYEOF) {
+        break;
+      }
+    }
+  } catch(const EbnfToBison::syntax_error& e) {
+    stringstream s;
+    s << "error " << e.location << " " << e.what();
+    tokens.push_back(s.str());
+  }
+  return tokens;
+}
+
+vector<string> flexTokens(string_view input) {
+  stringstream s{string(input)};
+  Lexer lexer(&s);
+  return tokenStream(lexer);
+}
+
+vector<string> simdTokens(string_view input) {
+  SimdLexer lexer(input);
+  return tokenStream(lexer);
+}
+
+}
+
+TEST(SimdLexer, test_0) {
+
+  SimdLexer lexer("<true literal>");
+
+  location loc{};
+
+  auto token = lexer.yylex(loc);
+
+  EXPECT_EQ(token.kind(), EbnfToBison::symbol_kind::S_NONTERMINAL);
+}
+
+TEST(SimdLexer, test_1) {
+
+  string_view input = R"%(header line
+<x> ::= A [ <y> ] { B | "c\"d" }... !! comment
+<z>  ::= E	<w>
+<v>	::= F
+)%";
+
+  auto tokens = simdTokens(input);
+  EXPECT_THAT(tokens, ElementsAreArray(flexTokens(input)));
+// only spaces are allowed between nonterminal and ::= at start of rule
+  EXPECT_THAT(tokens, Contains("RULE_SEPARATOR 2.47-3.0"));
+  EXPECT_THAT(tokens, Contains("NONTERMINAL 3.15-4.3 [<v>]"));
+}
+
+// long runs cross simd block boundaries
+TEST(SimdLexer, test_2) {
+
+  auto input = "<"s + string(100, 'n') + " " + string(70, 'm') + "> ::= " + string(90, 'T') + string(40, ' ') + "\t\"" + string(50, 'l') + "\"\n";
+
+  EXPECT_THAT(simdTokens(input), ElementsAreArray(flexTokens(input)));
+}
+
+TEST(SimdLexer, test_3) {
+
+  for(auto input: {"<x> ::= a : b", "<x> ::= a .. b", "<x> ::= < a", "<x> ::= \"abc", "<x> ::= a ! b", "<x> ::= \xc3\xa9"}) {
+    auto tokens = simdTokens(input);
+    EXPECT_THAT(tokens, ElementsAreArray(flexTokens(input))) << input;
+    EXPECT_THAT(tokens.back(), StartsWith("error ")) << input;
+  }
+}
+
+// same token stream as flex lexer for every grammar in docs/
+TEST(SimdLexer, test_docs) {
+
+  auto numFiles = 0;
+  for(const auto& entry: filesystem::directory_iterator(EBNFTOBISON_DOCS_DIR)) {
+    if(!entry.is_regular_file()) {
+      continue;
+    }
+    ++numFiles;
+    MappedFile mappedFile;
+    ASSERT_TRUE(mappedFile.open(entry.path().string())) << entry.path();
+
+    auto expected = flexTokens(mappedFile.contents());
+    auto actual = simdTokens(mappedFile.contents());
+
+    EXPECT_GT(actual.size(), 1000) << entry.path();
+    EXPECT_EQ(actual, expected) << entry.path();
+  }
+  EXPECT_GT(numFiles, 0);
+}
+
+}
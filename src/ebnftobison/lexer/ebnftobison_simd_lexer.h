@@ -0,0 +1,91 @@
+#ifndef EBNFTOBISON_SIMD_LEXER_H
+#define EBNFTOBISON_SIMD_LEXER_H
+// ebnftobison_simd_lexer.h
+
+/*
+MIT License
+
+Copyright (c) 2024 Zartaj Majeed
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <istream>
+#include <string>
+#include <string_view>
+
+#include "ebnftobison.bison.h"
+#include "lexer/ebnftobison_pending_tokens.h"
+
+namespace ebnftobison {
+using namespace std;
+
+// hand-written drop-in alternative to the flex Lexer
+// produces exactly the same tokens, values and locations as the rules in ebnftobison.flex.l
+// runs of whitespace, identifier and nonterminal characters are matched 16 bytes at a time with SSE2, or 32 with AVX2 when enabled
+// always scans one contiguous buffer in place, token values are views into that buffer
+class SimdLexer {
+public:
+
+  EbnfToBison::symbol_type yylex(location&);
+
+  SimdLexer() = default;
+
+  explicit SimdLexer(string_view buffer) { switch_buffer(buffer); }
+
+  explicit SimdLexer(istream* in) { switch_streams(in); }
+
+// buffer must outlive the parse
+  void switch_buffer(string_view buffer);
+
+// reads all of the stream into a buffer owned by the lexer
+  void switch_streams(istream* in);
+
+// prints every token to stderr like the flex debug trace
+  void set_debug(int flag) { debug = flag; }
+
+private:
+
+// same start conditions as the flex lexer
+  enum class State {
+    header,
+    rules
+  };
+
+  EbnfToBison::symbol_type scanHeader(location&);
+  EbnfToBison::symbol_type scanRules(location&);
+
+  [[noreturn]] void badInput(location&);
+
+// tokens matched together with a rule separator
+  PendingTokens pendingTokens;
+
+  string_view input;
+  size_t pos = 0;
+  State state = State::header;
+
+  string streamContents;
+
+  int debug = 0;
+
+};
+
+}
+
+#endif
@@ -0,0 +1,150 @@
+#ifndef EBNFTOBISON_SPSC_RING_H
+#define EBNFTOBISON_SPSC_RING_H
+// ebnftobison_spsc_ring.h
+
+/*
+MIT License
+
+Copyright (c) 2024 Zartaj Majeed
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <optional>
+#include <vector>
+
+namespace ebnftobison {
+using namespace std;
+
+// bounded lock-free ring between exactly one producer thread and one consumer thread
+// items only need to be move constructible, bison symbols can't be assigned
+// each side owns one index and keeps a cached copy of the other so a push or pop usually touches no shared cache line
+// a side that finds the ring full or empty sleeps on a signal counter the other side bumps after every push or pop
+template<typename T>
+class SpscRing {
+public:
+
+// capacity is rounded up to a power of 2
+  explicit SpscRing(size_t capacity): slots(bit_ceil(max<size_t>(capacity, 2))), mask(slots.size() - 1) {}
+
+  SpscRing(const SpscRing&) = delete;
+  SpscRing& operator=(const SpscRing&) = delete;
+
+  size_t capacity() const { return slots.size(); }
+
+// producer only, value is moved into the ring when there is room
+  bool tryPush(T& value) {
+    auto t = tail.load(memory_order::relaxed);
+    if(t - cachedHead == slots.size()) {
+      cachedHead = head.load(memory_order::acquire);
+      if(t - cachedHead == slots.size()) {
+        return false;
+      }
+    }
+    slots[t & mask].emplace(std::move(value));
+    tail.store(t + 1, memory_order::release);
+    itemSignal.fetch_add(1, memory_order::release);
+    itemSignal.notify_one();
+    return true;
+  }
+
+// consumer only
+  bool tryPop(optional<T>& value) {
+    auto h = head.load(memory_order::relaxed);
+    if(h == cachedTail) {
+      cachedTail = tail.load(memory_order::acquire);
+      if(h == cachedTail) {
+        return false;
+      }
+    }
+    auto& slot = slots[h & mask];
+    value.emplace(std::move(*slot));
+    slot.reset();
+    head.store(h + 1, memory_order::release);
+    roomSignal.fetch_add(1, memory_order::release);
+    roomSignal.notify_one();
+    return true;
+  }
+
+// producer only, returns false if the ring was closed before there was room
+  bool waitForRoom() {
+    for(;;) {
+      auto signal = roomSignal.load(memory_order::acquire);
+      if(tail.load(memory_order::relaxed) - head.load(memory_order::acquire) < slots.size()) {
+        return true;
+      }
+      if(isClosed.load(memory_order::acquire)) {
+        return false;
+      }
+      roomSignal.wait(signal, memory_order::acquire);
+    }
+  }
+
+// consumer only, returns false if the ring was closed while empty
+  bool waitForItem() {
+    for(;;) {
+      auto signal = itemSignal.load(memory_order::acquire);
+      if(tail.load(memory_order::acquire) != head.load(memory_order::relaxed)) {
+        return true;
+      }
+      if(isClosed.load(memory_order::acquire)) {
+        return false;
+      }
+      itemSignal.wait(signal, memory_order::acquire);
+    }
+  }
+
+// either side, wakes a waiting side for good
+  void close() {
+    isClosed.store(true, memory_order::release);
+    itemSignal.fetch_add(1, memory_order::release);
+    itemSignal.notify_all();
+    roomSignal.fetch_add(1, memory_order::release);
+    roomSignal.notify_all();
+  }
+
+private:
+
+  static constexpr size_t cacheLine = 64;
+
+  vector<optional<T>> slots;
+  size_t mask;
+
+// next slot to pop, written by the consumer
+  alignas(cacheLine) atomic<size_t> head{0};
+  size_t cachedTail = 0;
+  atomic<uint32_t> roomSignal{0};
+
+// next slot to push, written by the producer
+  alignas(cacheLine) atomic<size_t> tail{0};
+  size_t cachedHead = 0;
+  atomic<uint32_t> itemSignal{0};
+
+  alignas(cacheLine) atomic<bool> isClosed{false};
+
+};
+
+}
+
+#endif
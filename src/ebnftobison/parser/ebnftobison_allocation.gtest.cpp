@@ -0,0 +1,190 @@
+// ebnftobison_allocation.gtest.cpp
+
+/*
+MIT License
+
+Copyright (c) 2024 Zartaj Majeed
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <atomic>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <new>
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include "lexer/ebnftobison_lexer.h"
+#include "ebnftobison.bison.h"
+
+using namespace std;
+
+using namespace ::testing;
+
+// global operator new is replaced for this whole test binary so every heap allocation can be counted
+// counting is only switched on while a test is parsing
+namespace {
+
+atomic<bool> countAllocations;
+atomic<uint64_t> numAllocations;
+atomic<uint64_t> bytesAllocated;
+
+void* allocate(size_t size, size_t alignment = 0) {
+  if(countAllocations.load(memory_order_relaxed)) {
+    numAllocations.fetch_add(1, memory_order_relaxed);
+    bytesAllocated.fetch_add(size, memory_order_relaxed);
+  }
+  auto p = alignment > alignof(max_align_t)? aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment): malloc(size == 0? 1: size);
+  if(p == nullptr) {
+    throw bad_alloc();
+  }
+  return p;
+}
+
+}
+
+void* operator new(size_t size) {
+  return allocate(size);
+}
+
+void* operator new[](size_t size) {
+  return allocate(size);
+}
+
+void* operator new(size_t size, align_val_t alignment) {
+  return allocate(size, static_cast<size_t>(alignment));
+}
+
+void* operator new[](size_t size, align_val_t alignment) {
+  return allocate(size, static_cast<size_t>(alignment));
+}
+
+void operator delete(void* p) noexcept {
+  free(p);
+}
+
+void operator delete[](void* p) noexcept {
+  free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+  free(p);
+}
+
+void operator delete[](void* p, size_t) noexcept {
+  free(p);
+}
+
+void operator delete(void* p, align_val_t) noexcept {
+  free(p);
+}
+
+void operator delete[](void* p, align_val_t) noexcept {
+  free(p);
+}
+
+void operator delete(void* p, size_t, align_val_t) noexcept {
+  free(p);
+}
+
+void operator delete[](void* p, size_t, align_val_t) noexcept {
+  free(p);
+}
+
+namespace ebnftobison::testing {
+
+class Allocations: public Test {
+protected:
+
+  void SetUp() override {
+    numAllocations = 0;
+    bytesAllocated = 0;
+  }
+
+// counts allocations made while parsing the grammar file, not while setting up the lexer and parser
+  int parse(const string& filename, BisonParam& bisonParam) {
+    ifstream s(filename);
+    Lexer lexer(&s);
+
+    location loc{};
+    EbnfToBison parser([&lexer](location& loc) -> EbnfToBison::symbol_type {
+      return lexer.yylex(loc);
+    },
+    bisonParam,
+    loc);
+
+    countAllocations = true;
+    auto ev = parser();
+    countAllocations = false;
+    return ev;
+  }
+
+};
+
+TEST_F(Allocations, test_0) {
+
+// gqlgrammar.txt doesn't convert, literals like |+| have to be quoted
+  BisonParam bisonParam;
+  ASSERT_EQ(parse(EBNFTOBISON_DOCS_DIR "/gqlgrammar.quotedliterals.txt", bisonParam), 0);
+
+// about 12800 allocations and 1.6MB when this was written, most of them for ebnf trees and interned names
+// a copied semantic value or a container that leaves the arena shows up here first
+  EXPECT_LT(numAllocations, 15000);
+  EXPECT_LT(bytesAllocated, 2'000'000);
+}
+
+TEST_F(Allocations, test_1) {
+
+// long concatenations and alternatives are appended to in place, not copied at every reduction
+  string rule = "<x> ::=";
+  for(int i = 0; i < 1000; ++i) {
+    rule += " a";
+  }
+  for(int i = 0; i < 1000; ++i) {
+    rule += " | b";
+  }
+  rule += "\n";
+
+  stringstream s(rule);
+  Lexer lexer(&s);
+
+  location loc{};
+  BisonParam bisonParam;
+  EbnfToBison parser([&lexer](location& loc) -> EbnfToBison::symbol_type {
+    return lexer.yylex(loc);
+  },
+  bisonParam,
+  loc);
+
+  countAllocations = true;
+  auto ev = parser();
+  countAllocations = false;
+  ASSERT_EQ(ev, 0);
+
+// one children vector per alternative plus doubling of the long ones, about 1060
+// copying the concatenation or the alternative at every reduction would add an allocation per reduction for each
+  EXPECT_LT(numAllocations, 1500);
+}
+
+}
+
@@ -0,0 +1,97 @@
+// ebnftobison_incremental.cpp
+
+/*
+MIT License
+
+Copyright (c) 2024 Zartaj Majeed
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <memory>
+
+#include "parser/ebnftobison_incremental.h"
+#include "parser/ebnftobison_sharded.h"
+
+namespace ebnftobison {
+
+IncrementalConverter::IncrementalConverter(BisonParam& bisonParam, const string* filename, bool useSimdLexer, size_t minPieceSize): bisonParam(bisonParam), filename(filename), useSimdLexer(useSimdLexer), minPieceSize(minPieceSize) {
+  bisonParam.stats = {};
+  bisonParam.stats.parseStartTime = steady_clock::now();
+  bisonParam.diagnostics.clear();
+}
+
+// only whole lines are checked, a rule start split between chunks is seen once the rest of its line is in
+int IncrementalConverter::feed(const char* data, size_t length) {
+  if(error != 0 || finished) {
+    return error;
+  }
+  pending.append(data, length);
+  for(size_t lineEnd; (lineEnd = pending.find('\n', scanned)) != string::npos; ++scannedLine) {
+    if(isRuleStart(pending, scanned)) {
+      if(seenRule && scanned > 0) {
+        cut = scanned;
+        cutLine = scannedLine;
+      }
+      seenRule = true;
+    }
+    scanned = lineEnd + 1;
+  }
+  if(cut >= minPieceSize) {
+    return parsePiece(cut, cutLine);
+  }
+  return 0;
+}
+
+int IncrementalConverter::finish() {
+  if(finished) {
+    return error;
+  }
+  finished = true;
+  if(error == 0) {
+    parsePiece(pending.size(), scannedLine);
+  }
+  auto& stats = bisonParam.stats;
+  if(error == 0) {
+    setMergedCounts(stats, offsets);
+  }
+  stats.parseEndTime = steady_clock::now();
+  stats.parseTimeTakenSec = stats.parseEndTime - stats.parseStartTime;
+  return error;
+}
+
+// merged symbols and sequences are copies, so the parsed text can be dropped right after the merge
+int IncrementalConverter::parsePiece(size_t length, unsigned nextLine) {
+  BisonParam pieceParam;
+  if(auto ev = parseShard({.text = string_view(pending).substr(0, length), .firstLine = pendingLine}, filename, bisonParam.options, useSimdLexer, pieceParam); ev != 0) {
+    error = ev;
+    bisonParam.diagnostics = std::move(pieceParam.diagnostics);
+    bisonParam.result.clear();
+    return error;
+  }
+  mergeShard(bisonParam, pieceParam, offsets);
+
+  pending.erase(0, length);
+  pendingLine = nextLine;
+  scanned -= length;
+  cut = 0;
+  return 0;
+}
+
+}
@@ -0,0 +1,88 @@
+#ifndef EBNFTOBISON_INCREMENTAL_H
+#define EBNFTOBISON_INCREMENTAL_H
+// ebnftobison_incremental.h
+
+/*
+MIT License
+
+Copyright (c) 2024 Zartaj Majeed
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+#include "ebnftobison.bison.h"
+
+namespace ebnftobison {
+using namespace std;
+
+// converts a grammar handed over in chunks as they arrive, without a thread waiting inside the lexer for more input
+// the bison c++ skeleton lalr1.cc has no push mode, so instead of suspending the parser the input is cut where a rule starts at the beginning of a line
+// every complete piece is parsed on its own as soon as it's in and merged like a shard, the result is the same as parsing all of the input at once
+class IncrementalConverter {
+public:
+
+// pieces shorter than minPieceSize are held back until more input comes, to keep parses per chunk few
+  static constexpr size_t defaultMinPieceSize = 1 << 16;
+
+// bisonParam gives the options and collects the merged result, keepTrees and ruleSink aren't supported
+  explicit IncrementalConverter(BisonParam& bisonParam, const string* filename = nullptr, bool useSimdLexer = false, size_t minPieceSize = defaultMinPieceSize);
+
+// takes the next chunk and parses the pieces it completes
+// returns 0 like the parser or the error of the first piece that failed, after which nothing more is parsed
+  int feed(const char* data, size_t length);
+
+  int feed(string_view data) { return feed(data.data(), data.size()); }
+
+// parses what is left and sets the stats of the whole conversion, anything fed after this is ignored
+  int finish();
+
+private:
+
+  int parsePiece(size_t length, unsigned nextLine);
+
+  BisonParam& bisonParam;
+  const string* filename;
+  bool useSimdLexer;
+  size_t minPieceSize;
+
+// input not parsed yet, starts with a rule except before the first piece when it also has the header
+  string pending;
+  unsigned pendingLine = 1;
+// lines of pending before scanned have been checked for rule starts
+  size_t scanned = 0;
+  unsigned scannedLine = 1;
+// start of the last rule found in pending that can begin a new piece, 0 if there is none
+  size_t cut = 0;
+  unsigned cutLine = 1;
+// first rule of the grammar stays with the header
+  bool seenRule = false;
+
+  BisonParam::Stats offsets;
+  int error = 0;
+  bool finished = false;
+
+};
+
+}
+
+#endif
@@ -0,0 +1,450 @@
+// ebnftobison_main.cpp
+
+/*
+MIT License
+
+Copyright (c) 2024 Zartaj Majeed
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <getopt.h>
+#include <signal.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "api/ebnftobison_api.h"
+#include "api/ebnftobison_batch.h"
+#include "api/ebnftobison_server.h"
+#include "api/ebnftobison_watch.h"
+#include "api/ebnftobison_emitter.h"
+#include "lexer/ebnftobison_mapped_file.h"
+
+using namespace std;
+using namespace ebnftobison;
+
+// command line front end of the converter library
+
+void usage() {
+  puts("Usage: ebnftobison [-h | --help] [--debug] [--stats] [--simd-lexer] [--factor-threshold n] [--budget n] [--refuse-over-budget] [--predict] [--stream] [-j n | --jobs n] [--expand-threads n] [--pipeline] [--rule-cache dir] [--manifest file] [--output-dir dir] [--batch-threads n] [--serve socket] [--serve-threads n] [--serve-cache n] [--watch file] [--snapshot file] [--output file] [--print-threads n] [file...]");
+  puts("ebnftobison converts extended EBNF as defined in Section 5.2 of the GQL ISO-39075:2024 standard to a Bison grammar");
+  puts("");
+  puts("Options:");
+  puts("--debug: turns on Bison parser and Flex lexer debug traces, off by default");
+  puts("--stats: print timing stats on successful parse, off by default");
+  puts("--simd-lexer: use hand-written SIMD lexer instead of Flex lexer, off by default");
+  puts("--factor-threshold n: move optionals and alternative groups of a concatenation to helper rules opt_N and grp_N when distributing them would give more than n productions, 0 by default to always distribute");
+  puts("--budget n: factor any rule predicted to expand to more than n productions, counting list rules for its repetitions, 0 by default for no limit");
+  puts("--refuse-over-budget: fail the conversion instead of factoring a rule that is over budget");
+  puts("--predict: print predicted number of productions and symbols before each converted rule");
+  puts("--stream: keep rules as EBNF trees and enumerate their productions only while printing them, memory stays proportional to the EBNF, productions are printed in tree order and each distinct production once, can't be used with --factor-threshold or --budget");
+  puts("--jobs n | -j n: split input at rule boundaries and convert the pieces on n threads, output is the same as with 1 job, 1 by default, can't be used with --stream");
+  puts("--expand-threads n: split large cross products of a single rule into tasks run on a work-stealing pool of n threads, output is the same as with 1 thread, 1 by default");
+  puts("--pipeline: run the lexer on its own thread ahead of the parser, tokens are passed through a lock-free ring, can't be used with --jobs");
+  puts("--rule-cache dir: keep converted rules in files under dir and convert again only rules whose text or options changed, output is the same as without it, misses are converted on --jobs threads, can't be used with --stream or --pipeline");
+  puts("--manifest file: convert every grammar listed in file, one per line optionally followed by its output file, paths are relative to the manifest");
+  puts("--output-dir dir: write converted grammars to dir instead of next to their inputs");
+  puts("--batch-threads n: convert the files of a batch on n threads, number of cores by default");
+  puts("--serve socket: serve conversion requests on a unix socket until interrupted, --jobs and --expand-threads are the most a request may ask for, --rule-cache dir is shared by every worker and each keeps the rules of its last request in memory, --stats prints request counts on exit");
+  puts("--serve-threads n: serve connections on n threads, number of cores by default");
+  puts("--serve-cache n: keep responses to the last n distinct requests, 64 by default, 0 for none");
+  puts("--watch file: convert file to file.y and again every time it's saved, only rules that changed are converted again, the output is replaced once complete, a line with the time taken is printed for each conversion until interrupted");
+  puts("--snapshot file: also write the converted rules to file as a binary snapshot that GrammarView in ebnftobison_snapshot.h loads with mmap, can't be used with --stream or with more than one grammar");
+  puts("--output file: write converted rules to file through a memory mapping instead of printing them after result:");
+  puts("--print-threads n: format rules on n threads and write them out in order, output is the same as with 1 thread, 1 by default, not used with --stream");
+  puts("--help | -h: prints usage help");
+  puts("file: extended EBNF grammar file, more than one file, --manifest or --output-dir convert a batch where each input.txt is written to input.y and --stats are totals of the batch");
+}
+
+void printConvertStats(const ConvertStats& stats) {
+  auto numRuleCacheLookups = stats.numRuleCacheHits + stats.numRuleCacheMisses;
+  auto ruleCacheHitRatio = numRuleCacheLookups == 0? 0.0: double(stats.numRuleCacheHits) / numRuleCacheLookups;
+  printf("parse_time %.9f secs, num_rules_parsed %lu, num_rules_generated %lu, num_productions_generated %lu, num_optionals_factored %lu, num_groups_factored %lu, num_choice_groups %lu, num_rules_over_budget %lu, num_sequence_nodes %zu, sequence_bytes %zu, arena_allocations %lu, arena_bytes %lu, arena_heap_chunks %lu, arena_heap_bytes %lu, expand_tasks %lu, expand_tasks_stolen %lu, expand_task_time %.9f secs, max_expand_task_time %.9f secs, lexer_stall_time %.9f secs, parser_stall_time %.9f secs, rule_cache_hits %lu, rule_cache_misses %lu, rule_cache_hit_ratio %.3f\n", stats.parseTime.count(), stats.numRulesParsed, stats.numRulesGenerated, stats.numProductionsGenerated, stats.numOptionalsFactored, stats.numGroupsFactored, stats.numChoiceGroups, stats.numRulesOverBudget, stats.numSequenceNodes, stats.sequenceBytes, stats.arenaAllocations, stats.arenaBytes, stats.arenaHeapChunks, stats.arenaHeapBytes, stats.numExpandTasks, stats.numExpandTasksStolen, stats.expandTaskTime.count(), stats.maxExpandTaskTime.count(), stats.lexerStallTime.count(), stats.parserStallTime.count(), stats.numRuleCacheHits, stats.numRuleCacheMisses, ruleCacheHitRatio);
+}
+
+// every file gets a converter of its own from the pool, one process pays for startup once for the whole batch
+int runBatch(const vector<BatchEntry>& entries, const ConvertOptions& options, size_t numThreads, bool printStats) {
+  if(auto error = checkBatch(entries); !error.empty()) {
+    fprintf(stderr, "%s\n", error.c_str());
+    return 1;
+  }
+
+  auto startTime = chrono::steady_clock::now();
+  auto results = convertBatch(entries, options, numThreads);
+  chrono::duration<double> batchTime = chrono::steady_clock::now() - startTime;
+
+  ConvertStats total;
+  size_t numFailed = 0;
+  for(size_t k = 0; k < entries.size(); ++k) {
+    const auto& result = results[k];
+    if(result.status != 0) {
+      ++numFailed;
+      for(const auto& diagnostic: result.diagnostics) {
+        fprintf(stderr, "%s\n", diagnostic.c_str());
+      }
+      fprintf(stderr, "conversion of %s failed\n", entries[k].input.c_str());
+      continue;
+    }
+    addStats(total, result.stats);
+  }
+
+  if(printStats) {
+    printf("batch_files %zu, batch_failed %zu, batch_threads %zu, batch_time %.9f secs, ", entries.size(), numFailed, min(numThreads, entries.size()), batchTime.count());
+    printConvertStats(total);
+  }
+
+  if(numFailed > 0) {
+    fprintf(stderr, "%zu of %zu conversions failed\n", numFailed, entries.size());
+    return 1;
+  }
+  return 0;
+}
+
+ConversionServer* runningServer = nullptr;
+
+void stopServer(int) {
+  runningServer->stop();
+}
+
+int serve(const ConversionServer::Options& serverOptions, bool printStats) {
+  ConversionServer server(serverOptions);
+  if(string error; !server.listen(error)) {
+    fprintf(stderr, "%s\n", error.c_str());
+    return 1;
+  }
+
+  runningServer = &server;
+  struct sigaction action{};
+  action.sa_handler = stopServer;
+  sigaction(SIGINT, &action, nullptr);
+  sigaction(SIGTERM, &action, nullptr);
+
+  server.run();
+
+  if(printStats) {
+    auto stats = server.stats();
+    printf("connections %lu, requests %lu, cache_hits %lu, failed %lu, rule_cache_hits %lu, rule_cache_misses %lu\n", stats.numConnections, stats.numRequests, stats.numCacheHits, stats.numFailed, stats.numRuleCacheHits, stats.numRuleCacheMisses);
+  }
+  return 0;
+}
+
+GrammarWatcher* runningWatcher = nullptr;
+
+void stopWatcher(int) {
+  runningWatcher->stop();
+}
+
+int watch(const string& input, const string& output, const ConvertOptions& options) {
+  GrammarWatcher watcher(input, output, options);
+  if(string error; !watcher.watch(error)) {
+    fprintf(stderr, "%s\n", error.c_str());
+    return 1;
+  }
+
+  runningWatcher = &watcher;
+  struct sigaction action{};
+  action.sa_handler = stopWatcher;
+  sigaction(SIGINT, &action, nullptr);
+  sigaction(SIGTERM, &action, nullptr);
+
+  uint64_t numEvents = 0;
+  watcher.run([&](const GrammarWatcher::Event& event) {
+    for(const auto& diagnostic: event.diagnostics) {
+      fprintf(stderr, "%s\n", diagnostic.c_str());
+    }
+    printf("watch_event %lu, status %d, rules %lu, rules_converted %lu, convert_time %.9f secs, write_time %.9f secs, total_time %.9f secs\n", numEvents++, event.status, event.numRules, event.numRulesConverted, event.convertTime.count(), event.writeTime.count(), event.totalTime.count());
+    fflush(stdout);
+  });
+  return 0;
+}
+
+int main(int argc, char* argv[])
+{
+  ios_base::sync_with_stdio(false);
+
+// getopt stores flags as int, a narrower flag would have its neighbours overwritten
+  int debug{};
+  int printStats{};
+  int useSimdLexer{};
+  int refuseOverBudget{};
+  int printPredictions{};
+  int streamOutput{};
+  int pipelineLexer{};
+  string manifestName;
+  string outputDir;
+  string watchName;
+  string snapshotName;
+  string outputName;
+  size_t printThreads = 1;
+  size_t batchThreads = max(thread::hardware_concurrency(), 1u);
+  ConversionServer::Options serverOptions;
+  serverOptions.numWorkers = batchThreads;
+
+  ConvertOptions options;
+  options.inputName = "stdin";
+
+  option opts[] = {
+    {"debug", no_argument, &debug, 1},
+    {"stats", no_argument, &printStats, 1},
+    {"simd-lexer", no_argument, &useSimdLexer, 1},
+    {"factor-threshold", required_argument, 0, 'f'},
+    {"budget", required_argument, 0, 'b'},
+    {"refuse-over-budget", no_argument, &refuseOverBudget, 1},
+    {"predict", no_argument, &printPredictions, 1},
+    {"stream", no_argument, &streamOutput, 1},
+    {"jobs", required_argument, 0, 'j'},
+    {"expand-threads", required_argument, 0, 'e'},
+    {"pipeline", no_argument, &pipelineLexer, 1},
+    {"rule-cache", required_argument, 0, 'r'},
+    {"manifest", required_argument, 0, 'm'},
+    {"output-dir", required_argument, 0, 'o'},
+    {"batch-threads", required_argument, 0, 't'},
+    {"serve", required_argument, 0, 's'},
+    {"serve-threads", required_argument, 0, 'w'},
+    {"serve-cache", required_argument, 0, 'c'},
+    {"watch", required_argument, 0, 'W'},
+    {"snapshot", required_argument, 0, 'S'},
+    {"output", required_argument, 0, 'O'},
+    {"print-threads", required_argument, 0, 'p'},
+    {"help", no_argument, 0, 'h'},
+    {0, 0, 0, 0}
+  };
+
+  for(int i, optLetter; (optLetter = getopt_long(argc, argv, "hj:", opts, &i)) != -1;) {
+    switch(optLetter) {
+    case 0:
+      break;
+    case 'f':
+      options.factorThreshold = strtoull(optarg, nullptr, 10);
+      break;
+    case 'b':
+      options.productionBudget = strtoull(optarg, nullptr, 10);
+      break;
+    case 'j':
+      options.numJobs = max(strtoull(optarg, nullptr, 10), 1ull);
+      break;
+    case 'e':
+      options.expandThreads = max(strtoull(optarg, nullptr, 10), 1ull);
+      break;
+    case 'r':
+      options.ruleCacheDir = optarg;
+      break;
+    case 'm':
+      manifestName = optarg;
+      break;
+    case 'o':
+      outputDir = optarg;
+      break;
+    case 't':
+      batchThreads = max(strtoull(optarg, nullptr, 10), 1ull);
+      break;
+    case 's':
+      serverOptions.socketPath = optarg;
+      break;
+    case 'w':
+      serverOptions.numWorkers = max(strtoull(optarg, nullptr, 10), 1ull);
+      break;
+    case 'c':
+      serverOptions.cacheSize = strtoull(optarg, nullptr, 10);
+      break;
+    case 'W':
+      watchName = optarg;
+      break;
+    case 'S':
+      snapshotName = optarg;
+      break;
+    case 'O':
+      outputName = optarg;
+      break;
+    case 'p':
+      printThreads = max(strtoull(optarg, nullptr, 10), 1ull);
+      break;
+    case 'h':
+      usage();
+      return 0;
+    case '?':
+      usage();
+      return 1;
+    default:
+      break;
+    }
+  }
+
+  options.debug = debug;
+  options.useSimdLexer = useSimdLexer;
+  options.refuseOverBudget = refuseOverBudget;
+  options.predictions = printPredictions;
+  options.stream = streamOutput;
+  options.pipeline = pipelineLexer;
+
+  if(options.stream && (options.factorThreshold > 0 || options.productionBudget > 0)) {
+    fputs("--stream can't be used with --factor-threshold or --budget\n", stderr);
+    return 1;
+  }
+  if(options.stream && options.numJobs > 1) {
+    fputs("--stream can't be used with --jobs\n", stderr);
+    return 1;
+  }
+  if(options.pipeline && options.numJobs > 1) {
+    fputs("--pipeline can't be used with --jobs\n", stderr);
+    return 1;
+  }
+  if(!options.ruleCacheDir.empty() && (options.stream || options.pipeline)) {
+    fputs("--rule-cache can't be used with --stream or --pipeline\n", stderr);
+    return 1;
+  }
+
+  if(!outputName.empty() && (!watchName.empty() || !serverOptions.socketPath.empty() || !manifestName.empty() || !outputDir.empty() || argc - optind > 1)) {
+    fputs("--output can't be used with --watch, --serve or a batch\n", stderr);
+    return 1;
+  }
+  if(!snapshotName.empty() && (options.stream || !watchName.empty() || !serverOptions.socketPath.empty() || !manifestName.empty() || !outputDir.empty() || argc - optind > 1)) {
+    fputs("--snapshot can't be used with --stream, --watch, --serve or a batch\n", stderr);
+    return 1;
+  }
+
+// rules of the last conversion are kept in the watcher's converter
+  if(!watchName.empty()) {
+    if(options.stream || options.pipeline) {
+      fputs("--watch can't be used with --stream or --pipeline\n", stderr);
+      return 1;
+    }
+    auto output = batchOutputName(watchName, outputDir);
+    if(resolvedPath(output) == resolvedPath(watchName)) {
+      fprintf(stderr, "output \"%s\" would overwrite the watched file\n", output.c_str());
+      return 1;
+    }
+    return watch(watchName, output, options);
+  }
+
+// conversion options come with each request
+  if(!serverOptions.socketPath.empty()) {
+    serverOptions.maxJobs = options.numJobs;
+    serverOptions.maxExpandThreads = options.expandThreads;
+    serverOptions.ruleCacheDir = options.ruleCacheDir;
+    serverOptions.keepRules = !options.ruleCacheDir.empty();
+    return serve(serverOptions, printStats);
+  }
+
+  if(!manifestName.empty() || !outputDir.empty() || argc - optind > 1) {
+    vector<BatchEntry> entries;
+    if(!manifestName.empty()) {
+      ifstream manifest(manifestName);
+      if(!manifest) {
+        fprintf(stderr, "error opening file \"%s\"\n", manifestName.c_str());
+        return 1;
+      }
+      if(string error; !readManifest(manifest, manifestName, outputDir, entries, error)) {
+        fprintf(stderr, "%s\n", error.c_str());
+        return 1;
+      }
+    }
+    for(int i = optind; i < argc; ++i) {
+      entries.push_back({.input = argv[i], .output = batchOutputName(argv[i], outputDir)});
+    }
+    return runBatch(entries, options, batchThreads, printStats);
+  }
+
+  Converter converter;
+  ConvertedGrammar converted;
+
+// regular files are memory mapped and scanned in place, anything else like a pipe is read as a stream
+  MappedFile mappedFile;
+  ifstream fileStream;
+  if(optind < argc) {
+    options.inputName = argv[optind];
+    if(mappedFile.open(options.inputName)) {
+      converter.parse(mappedFile.contents(), options, converted);
+    } else if(fileStream.open(options.inputName); !fileStream) {
+      fprintf(stderr, "error opening file \"%s\"\n", options.inputName.c_str());
+      exit(1);
+    } else {
+      converter.parse(fileStream, options, converted);
+    }
+  } else {
+    converter.parse(cin, options, converted);
+  }
+
+  if(!converted) {
+    for(const auto& diagnostic: converted.diagnostics) {
+      fprintf(stderr, "%s\n", diagnostic.c_str());
+    }
+    fputs("parse failed\n", stderr);
+    return converted.status;
+  }
+
+  if(printStats) {
+    printConvertStats(converted.stats);
+  }
+
+// snapshot is renamed into place once complete like batch outputs
+  if(!snapshotName.empty()) {
+    string snapshot;
+    converter.printSnapshot(snapshot);
+    auto temporary = temporaryName(snapshotName);
+    auto out = fopen(temporary.c_str(), "w");
+    auto written = out != nullptr && fwrite(snapshot.data(), 1, snapshot.size(), out) == snapshot.size();
+    written = out != nullptr && fclose(out) == 0 && written;
+    if(!written || rename(temporary.c_str(), snapshotName.c_str()) != 0) {
+      remove(temporary.c_str());
+      fprintf(stderr, "error writing file \"%s\"\n", snapshotName.c_str());
+      return 1;
+    }
+  }
+
+// output file is written through a mapping and renamed into place once complete
+  if(!outputName.empty()) {
+    auto temporary = temporaryName(outputName);
+    MappedFileEmitter emitter;
+    auto written = emitter.open(temporary);
+    if(written) {
+      converter.print(emitter, printThreads);
+      written = emitter.finish();
+    }
+    if(!written || rename(temporary.c_str(), outputName.c_str()) != 0) {
+      remove(temporary.c_str());
+      fprintf(stderr, "error writing file \"%s\"\n", outputName.c_str());
+      return 1;
+    }
+    return 0;
+  }
+
+  puts("");
+  puts("result:");
+  fflush(stdout);
+// rules bypass stdio and go out in large pieces gathered with writev
+  FdEmitter emitter(STDOUT_FILENO);
+  converter.print(emitter, printThreads);
+  if(!emitter.finish()) {
+    fputs("error writing output\n", stderr);
+    return 1;
+  }
+
+  return 0;
+}
@@ -24,13 +24,25 @@ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 SOFTWARE.
 */
 
+#include <unistd.h>
+
+#include <filesystem>
+#include <fstream>
+#include <random>
 #include <sstream>
 #include <string>
+#include <thread>
+#include <vector>
 
 #include <gtest/gtest.h>
 #include <gmock/gmock.h>
 
 #include "lexer/ebnftobison_lexer.h"
+#include "lexer/ebnftobison_pipelined_lexer.h"
+#include "converter/ebnftobison_enumerator.h"
+#include "parser/ebnftobison_sharded.h"
+#include "parser/ebnftobison_incremental.h"
+#include "parser/ebnftobison_rule_cache.h"
 #include "ebnftobison.bison.h"
 
 using namespace std;
@@ -53,9 +65,9 @@ TEST(EbnfToBison, test_0) {
   bisonParam,
   loc);
 
-  auto& result = bisonParam.result;
-
   EXPECT_EQ(parser(), 0);
+
+  auto result = bisonParam.namedResult();
   EXPECT_EQ(result.size(), 1);
   EXPECT_TRUE(result.contains("true_literal"));
   EXPECT_EQ(result, (map<string, set<vector<string>>>{ {"true_literal", { {"TRUE"} } } }) );
@@ -81,9 +93,9 @@ TEST(EbnfToBison, test_1) {
   bisonParam,
   loc);
 
-  auto& result = bisonParam.result;
-
   EXPECT_EQ(parser(), 0);
+
+  auto result = bisonParam.namedResult();
   EXPECT_EQ(result.size(), 1);
   EXPECT_TRUE(result.contains("true_literal"));
   EXPECT_EQ(result["true_literal"].size(), 3);
@@ -105,9 +117,9 @@ TEST(EbnfToBison, test_2) {
   bisonParam,
   loc);
 
-  auto& result = bisonParam.result;
-
   EXPECT_EQ(parser(), 0);
+
+  auto result = bisonParam.namedResult();
   EXPECT_EQ(result.size(), 1);
   EXPECT_EQ(result["nested_query_specification"].size(), 1);
   EXPECT_THAT(result, UnorderedElementsAreArray( (map<string, set<vector<string>>>{ {"nested_query_specification", { {"left_brace", "query_specification", "right_brace"} } } }) ));
@@ -132,9 +144,9 @@ TEST(EbnfToBison, test_3) {
   bisonParam,
   loc);
 
-  auto& result = bisonParam.result;
-
   EXPECT_EQ(parser(), 0);
+
+  auto result = bisonParam.namedResult();
   EXPECT_EQ(result.size(), 1);
   EXPECT_TRUE(result.contains("GQL_program"));
   EXPECT_EQ(result["GQL_program"].size(), 3);
@@ -168,9 +180,9 @@ TEST(EbnfToBison, test_4) {
   bisonParam,
   loc);
 
-  auto& result = bisonParam.result;
-
   EXPECT_EQ(parser(), 0);
+
+  auto result = bisonParam.namedResult();
   EXPECT_EQ(result.size(), 2);
   EXPECT_TRUE(result.contains("session_activity"));
   EXPECT_TRUE(result.contains("session_reset_command_list"));
@@ -210,9 +222,9 @@ TEST(EbnfToBison, test_5) {
   bisonParam,
   loc);
 
-  auto& result = bisonParam.result;
-
   EXPECT_EQ(parser(), 0);
+
+  auto result = bisonParam.namedResult();
   EXPECT_EQ(result.size(), 3);
   EXPECT_TRUE(result.contains("session_activity"));
   EXPECT_TRUE(result.contains("session_reset_command_list"));
@@ -260,9 +272,9 @@ TEST(EbnfToBison, test_6) {
   bisonParam,
   loc);
 
-  auto& result = bisonParam.result;
-
   EXPECT_EQ(parser(), 0);
+
+  auto result = bisonParam.namedResult();
   EXPECT_EQ(result.size(), 3);
   EXPECT_TRUE(result.contains("session_activity"));
   EXPECT_TRUE(result.contains("session_reset_command_list"));
@@ -311,9 +323,9 @@ TEST(EbnfToBison, test_7) {
   bisonParam,
   loc);
 
-  auto& result = bisonParam.result;
-
   EXPECT_EQ(parser(), 0);
+
+  auto result = bisonParam.namedResult();
   EXPECT_EQ(result.size(), 3);
   EXPECT_TRUE(result.contains("session_activity"));
   EXPECT_TRUE(result.contains("session_reset_command_list"));
@@ -362,9 +374,9 @@ TEST(EbnfToBison, test_8) {
   bisonParam,
   loc);
 
-  auto& result = bisonParam.result;
-
   EXPECT_EQ(parser(), 0);
+
+  auto result = bisonParam.namedResult();
   EXPECT_EQ(result.size(), 1);
   EXPECT_TRUE(result.contains("transaction_characteristics"));
   EXPECT_THAT(result, UnorderedElementsAreArray( (map<string, set<vector<string>>>{
@@ -395,9 +407,9 @@ TEST(EbnfToBison, test_9) {
   bisonParam,
   loc);
 
-  auto& result = bisonParam.result;
-
   EXPECT_EQ(parser(), 0);
+
+  auto result = bisonParam.namedResult();
   EXPECT_EQ(result.size(), 2);
   EXPECT_TRUE(result.contains("transaction_characteristics"));
   EXPECT_TRUE(result.contains("comma_transaction_mode_2_list"));
@@ -436,9 +448,9 @@ TEST(EbnfToBison, test_10) {
   bisonParam,
   loc);
 
-  auto& result = bisonParam.result;
-
   EXPECT_EQ(parser(), 0);
+
+  auto result = bisonParam.namedResult();
   EXPECT_EQ(result.size(), 2);
   EXPECT_TRUE(result.contains("transaction_characteristics"));
   EXPECT_TRUE(result.contains("comma_transaction_mode_2_list"));
@@ -479,9 +491,9 @@ TEST(EbnfToBison, test_11) {
   bisonParam,
   loc);
 
-  auto& result = bisonParam.result;
-
   EXPECT_EQ(parser(), 0);
+
+  auto result = bisonParam.namedResult();
   EXPECT_EQ(result.size(), 1);
   EXPECT_TRUE(result.contains("create_graph_statement"));
   EXPECT_THAT(result, UnorderedElementsAreArray( (map<string, set<vector<string>>>{
@@ -514,9 +526,9 @@ TEST(EbnfToBison, test_12) {
   bisonParam,
   loc);
 
-  auto& result = bisonParam.result;
-
   EXPECT_EQ(parser(), 0);
+
+  auto result = bisonParam.namedResult();
   EXPECT_EQ(result.size(), 1);
   EXPECT_TRUE(result.contains("create_graph_statement"));
   EXPECT_THAT(result, UnorderedElementsAreArray( (map<string, set<vector<string>>>{
@@ -555,9 +567,9 @@ TEST(EbnfToBison, test_13) {
   bisonParam,
   loc);
 
-  auto& result = bisonParam.result;
-
   EXPECT_EQ(parser(), 0);
+
+  auto result = bisonParam.namedResult();
   EXPECT_EQ(result.size(), 1);
   EXPECT_TRUE(result.contains("create_graph_statement"));
   EXPECT_THAT(result, UnorderedElementsAreArray( (map<string, set<vector<string>>>{
@@ -597,9 +609,9 @@ TEST(EbnfToBison, test_14) {
   bisonParam,
   loc);
 
-  auto& result = bisonParam.result;
-
   EXPECT_EQ(parser(), 0);
+
+  auto result = bisonParam.namedResult();
   EXPECT_EQ(result.size(), 1);
   EXPECT_TRUE(result.contains("create_graph_statement"));
   EXPECT_THAT(result, UnorderedElementsAreArray( (map<string, set<vector<string>>>{
@@ -648,9 +660,9 @@ TEST(EbnfToBison, test_15) {
   bisonParam,
   loc);
 
-  auto& result = bisonParam.result;
-
   EXPECT_EQ(parser(), 0);
+
+  auto result = bisonParam.namedResult();
   EXPECT_EQ(result.size(), 1);
   EXPECT_TRUE(result.contains("create_graph_statement"));
   EXPECT_THAT(result, UnorderedElementsAreArray( (map<string, set<vector<string>>>{
@@ -712,9 +724,9 @@ TEST(EbnfToBison, test_16) {
   bisonParam,
   loc);
 
-  auto& result = bisonParam.result;
-
   EXPECT_EQ(parser(), 0);
+
+  auto result = bisonParam.namedResult();
   EXPECT_EQ(result.size(), 1);
   EXPECT_TRUE(result.contains("delete_statement"));
   EXPECT_THAT(result, UnorderedElementsAreArray( (map<string, set<vector<string>>>{
@@ -751,9 +763,9 @@ TEST(EbnfToBison, test_17) {
   bisonParam,
   loc);
 
-  auto& result = bisonParam.result;
-
   EXPECT_EQ(parser(), 0);
+
+  auto result = bisonParam.namedResult();
   EXPECT_EQ(result.size(), 1);
   EXPECT_TRUE(result.contains("exists_predicate"));
   EXPECT_THAT(result, UnorderedElementsAreArray( (map<string, set<vector<string>>>{
@@ -789,9 +801,9 @@ TEST(EbnfToBison, test_18) {
   bisonParam,
   loc);
 
-  auto& result = bisonParam.result;
-
   EXPECT_EQ(parser(), 0);
+
+  auto result = bisonParam.namedResult();
   EXPECT_EQ(result.size(), 1);
   EXPECT_TRUE(result.contains("transaction_activity"));
   EXPECT_THAT(result, UnorderedElementsAreArray( (map<string, set<vector<string>>>{
@@ -827,9 +839,9 @@ TEST(EbnfToBison, test_19) {
   bisonParam,
   loc);
 
-  auto& result = bisonParam.result;
-
   EXPECT_EQ(parser(), 0);
+
+  auto result = bisonParam.namedResult();
   EXPECT_EQ(result.size(), 1);
   EXPECT_TRUE(result.contains("session_set_command"));
   EXPECT_THAT(result, UnorderedElementsAreArray( (map<string, set<vector<string>>>{
@@ -864,9 +876,9 @@ TEST(EbnfToBison, test_20) {
   bisonParam,
   loc);
 
-  auto& result = bisonParam.result;
-
   EXPECT_EQ(parser(), 0);
+
+  auto result = bisonParam.namedResult();
   EXPECT_EQ(result.size(), 1);
   EXPECT_TRUE(result.contains("single_quoted_character_representation"));
   EXPECT_THAT(result, UnorderedElementsAreArray( (map<string, set<vector<string>>>{
@@ -899,9 +911,9 @@ TEST(EbnfToBison, test_21) {
   bisonParam,
   loc);
 
-  auto& result = bisonParam.result;
-
   EXPECT_EQ(parser(), 0);
+
+  auto result = bisonParam.namedResult();
   EXPECT_EQ(result.size(), 1);
   EXPECT_TRUE(result.contains("double_single_quote"));
   EXPECT_THAT(result, UnorderedElementsAreArray( (map<string, set<vector<string>>>{
@@ -937,9 +949,9 @@ TEST(EbnfToBison, test_22) {
   bisonParam,
   loc);
 
-  auto& result = bisonParam.result;
-
   EXPECT_EQ(parser(), 0);
+
+  auto result = bisonParam.namedResult();
   EXPECT_EQ(result.size(), 2);
   EXPECT_TRUE(result.contains("GQL_program"));
   EXPECT_TRUE(result.contains("program_activity"));
@@ -988,9 +1000,9 @@ TEST(EbnfToBison, test_23) {
   bisonParam,
   loc);
 
-  auto& result = bisonParam.result;
-
   EXPECT_EQ(parser(), 0);
+
+  auto result = bisonParam.namedResult();
   EXPECT_EQ(result.size(), 2);
   EXPECT_TRUE(result.contains("GQL_program"));
   EXPECT_TRUE(result.contains("program_activity"));
@@ -1032,9 +1044,9 @@ TEST(EbnfToBison, test_24) {
   bisonParam,
   loc);
 
-  auto& result = bisonParam.result;
-
   EXPECT_EQ(parser(), 0);
+
+  auto result = bisonParam.namedResult();
   EXPECT_EQ(result.size(), 1);
   EXPECT_TRUE(result.contains("implementation_defined_access_mode"));
   EXPECT_THAT(result, UnorderedElementsAreArray( (map<string, set<vector<string>>>{
@@ -1067,9 +1079,9 @@ TEST(EbnfToBison, test_25) {
   bisonParam,
   loc);
 
-  auto& result = bisonParam.result;
-
   EXPECT_EQ(parser(), 0);
+
+  auto result = bisonParam.namedResult();
   EXPECT_EQ(result.size(), 2);
   EXPECT_TRUE(result.contains("implementation_defined_access_mode"));
   EXPECT_TRUE(result.contains("rollback_command"));
@@ -1110,9 +1122,9 @@ TEST(EbnfToBison, test_26) {
   bisonParam,
   loc);
 
-  auto& result = bisonParam.result;
-
   EXPECT_EQ(parser(), 0);
+
+  auto result = bisonParam.namedResult();
   EXPECT_EQ(result.size(), 1);
   EXPECT_TRUE(result.contains("pre_reserved_word"));
   EXPECT_THAT(result, UnorderedElementsAreArray( (map<string, set<vector<string>>>{
@@ -1150,9 +1162,9 @@ TEST(EbnfToBison, test_27) {
   bisonParam,
   loc);
 
-  auto& result = bisonParam.result;
-
   EXPECT_NE(parser(), 0);
+
+  auto result = bisonParam.namedResult();
   EXPECT_EQ(result.size(), 0);
 }
 
@@ -1174,9 +1186,9 @@ TEST(EbnfToBison, test_28) {
   bisonParam,
   loc);
 
-  auto& result = bisonParam.result;
-
   EXPECT_EQ(parser(), 0);
+
+  auto result = bisonParam.namedResult();
   EXPECT_EQ(result.size(), 1);
   EXPECT_TRUE(result.contains("space"));
   EXPECT_THAT(result, UnorderedElementsAreArray( (map<string, set<vector<string>>>{
@@ -1207,9 +1219,9 @@ TEST(EbnfToBison, test_29) {
   bisonParam,
   loc);
 
-  auto& result = bisonParam.result;
-
   EXPECT_EQ(parser(), 0);
+
+  auto result = bisonParam.namedResult();
   EXPECT_EQ(result.size(), 1);
   EXPECT_TRUE(result.contains("right_brace"));
   EXPECT_THAT(result, UnorderedElementsAreArray( (map<string, set<vector<string>>>{
@@ -1243,9 +1255,9 @@ TEST(EbnfToBison, test_30) {
   bisonParam,
   loc);
 
-  auto& result = bisonParam.result;
-
   EXPECT_EQ(parser(), 0);
+
+  auto result = bisonParam.namedResult();
   EXPECT_EQ(result.size(), 2);
   EXPECT_TRUE(result.contains("reverse_solidus"));
   EXPECT_TRUE(result.contains("right_brace"));
@@ -1280,9 +1292,9 @@ TEST(EbnfToBison, test_31) {
   bisonParam,
   loc);
 
-  auto& result = bisonParam.result;
-
   EXPECT_NE(parser(), 0);
+
+  auto result = bisonParam.namedResult();
   EXPECT_EQ(result.size(), 0);
 }
 
@@ -1305,9 +1317,9 @@ TEST(EbnfToBison, test_32) {
   bisonParam,
   loc);
 
-  auto& result = bisonParam.result;
-
   EXPECT_EQ(parser(), 0);
+
+  auto result = bisonParam.namedResult();
   EXPECT_EQ(result.size(), 3);
   EXPECT_TRUE(result.contains("separator"));
   EXPECT_TRUE(result.contains("choice_group_0_list"));
@@ -1353,9 +1365,9 @@ TEST(EbnfToBison, test_33) {
   bisonParam,
   loc);
 
-  auto& result = bisonParam.result;
-
   EXPECT_EQ(parser(), 0);
+
+  auto result = bisonParam.namedResult();
   EXPECT_EQ(result.size(), 1);
   EXPECT_TRUE(result.contains("x"));
   EXPECT_THAT(result, UnorderedElementsAreArray( (map<string, set<vector<string>>>{
@@ -1386,9 +1398,9 @@ TEST(EbnfToBison, test_34) {
   bisonParam,
   loc);
 
-  auto& result = bisonParam.result;
-
   EXPECT_EQ(parser(), 0);
+
+  auto result = bisonParam.namedResult();
   EXPECT_EQ(result.size(), 1);
   EXPECT_TRUE(result.contains("x"));
   EXPECT_THAT(result, UnorderedElementsAreArray( (map<string, set<vector<string>>>{
@@ -1419,9 +1431,9 @@ TEST(EbnfToBison, test_35) {
   bisonParam,
   loc);
 
-  auto& result = bisonParam.result;
-
   EXPECT_EQ(parser(), 0);
+
+  auto result = bisonParam.namedResult();
   EXPECT_EQ(result.size(), 1);
   EXPECT_TRUE(result.contains("x"));
   EXPECT_THAT(result, UnorderedElementsAreArray( (map<string, set<vector<string>>>{
@@ -1453,9 +1465,9 @@ TEST(EbnfToBison, test_36) {
   bisonParam,
   loc);
 
-  auto& result = bisonParam.result;
-
   EXPECT_EQ(parser(), 0);
+
+  auto result = bisonParam.namedResult();
   EXPECT_EQ(result.size(), 1);
   EXPECT_TRUE(result.contains("x"));
   EXPECT_THAT(result, UnorderedElementsAreArray( (map<string, set<vector<string>>>{
@@ -1470,5 +1482,726 @@ TEST(EbnfToBison, test_36) {
   }) ));
 }
 
+TEST(EbnfToBison, test_37) {
+
+  stringstream s(R"%(
+<session activity> ::=
+    <session reset command>...
+<x> ::= <a> <b> | <c>
+)%");
+
+  Lexer lexer(&s);
+
+  location loc{};
+  BisonParam bisonParam;
+
+  vector<pair<string, set<vector<string>>>> sunkRules;
+  bisonParam.ruleSink = [&sunkRules, &bisonParam](SymbolId ruleName, Production&& production) {
+    sunkRules.emplace_back(bisonParam.symbols.name(ruleName), bisonParam.namedProduction(production));
+  };
+
+  EbnfToBison parser([&lexer](location& loc) -> EbnfToBison::symbol_type {
+    return lexer.yylex(loc);
+  },
+  bisonParam,
+  loc);
+
+  EXPECT_EQ(parser(), 0);
+  EXPECT_TRUE(bisonParam.result.empty());
+  EXPECT_EQ(bisonParam.stats.numRulesGenerated, 3);
+// rules arrive in the order they are reduced, helper rules before the rule that uses them
+  EXPECT_THAT(sunkRules, ElementsAreArray( (vector<pair<string, set<vector<string>>>>{
+    {
+      "session_reset_command_list",
+      {
+        {"session_reset_command"},
+        {"session_reset_command_list", "session_reset_command"},
+      }
+    },
+    {
+      "session_activity",
+      {
+        {"session_reset_command_list"},
+      }
+    },
+    {
+      "x",
+      {
+        {"a", "b"},
+        {"c"},
+      }
+    },
+  }) ));
+}
+
+TEST(EbnfToBison, test_38) {
+
+  stringstream s("<x> ::= a [b] [c] [d]");
+  Lexer lexer(&s);
+
+  location loc{};
+  BisonParam bisonParam;
+  bisonParam.options.factorThreshold = 2;
+
+  EbnfToBison parser([&lexer](location& loc) -> EbnfToBison::symbol_type {
+    return lexer.yylex(loc);
+  },
+  bisonParam,
+  loc);
+
+  EXPECT_EQ(parser(), 0);
+  EXPECT_EQ(bisonParam.stats.numOptionalsFactored, 2);
+  EXPECT_EQ(bisonParam.stats.numGroupsFactored, 0);
+  EXPECT_EQ(bisonParam.stats.numProductionsGenerated, 6);
+
+  auto result = bisonParam.namedResult();
+// [b] still fits under the threshold and is distributed, [c] and [d] would double the productions each time
+  EXPECT_THAT(result, UnorderedElementsAreArray( (map<string, set<vector<string>>>{
+    {
+      "x",
+      {
+        {"a", "b", "opt_0", "opt_1"},
+        {"a", "opt_0", "opt_1"},
+      }
+    },
+    {
+      "opt_0",
+      {
+        {},
+        {"c"},
+      }
+    },
+    {
+      "opt_1",
+      {
+        {},
+        {"d"},
+      }
+    },
+  }) ));
+}
+
+TEST(EbnfToBison, test_39) {
+
+// total productions emitted for the GQL grammar with optionals and groups distributed and factored
+  auto convert = [](uint64_t factorThreshold) {
+    ifstream s(EBNFTOBISON_DOCS_DIR "/gqlgrammar.quotedliterals.txt");
+    Lexer lexer(&s);
+
+    location loc{};
+    BisonParam bisonParam;
+    bisonParam.options.factorThreshold = factorThreshold;
+
+    EbnfToBison parser([&lexer](location& loc) -> EbnfToBison::symbol_type {
+      return lexer.yylex(loc);
+    },
+    bisonParam,
+    loc);
+
+    EXPECT_EQ(parser(), 0);
+    return bisonParam.stats;
+  };
+
+  auto distributed = convert(0);
+  auto factored = convert(4);
+
+  EXPECT_EQ(distributed.numRulesParsed, factored.numRulesParsed);
+  EXPECT_EQ(distributed.numOptionalsFactored + distributed.numGroupsFactored, 0);
+  EXPECT_GT(factored.numOptionalsFactored, 0);
+  EXPECT_LT(factored.numProductionsGenerated, distributed.numProductionsGenerated);
 }
 
+TEST(EbnfToBison, test_40) {
+
+  stringstream s(R"%(
+<x> ::= a [b] [c] [d]
+<y> ::= {e | f}...
+)%");
+
+  Lexer lexer(&s);
+
+  location loc{};
+  BisonParam bisonParam;
+
+  EbnfToBison parser([&lexer](location& loc) -> EbnfToBison::symbol_type {
+    return lexer.yylex(loc);
+  },
+  bisonParam,
+  loc);
+
+  EXPECT_EQ(parser(), 0);
+
+  auto x = bisonParam.symbols.intern("x");
+  auto y = bisonParam.symbols.intern("y");
+  EXPECT_EQ(bisonParam.predictedSizes[x].numProductions, 8);
+  EXPECT_EQ(bisonParam.predictedSizes[x].numSymbols, 20);
+  EXPECT_EQ(bisonParam.predictedSizes[y].numProductions, 1);
+  EXPECT_EQ(bisonParam.predictedSizes[y].numListProductions, 4);
+  EXPECT_EQ(bisonParam.result[x].size(), 8);
+  EXPECT_EQ(bisonParam.stats.numRulesOverBudget, 0);
+}
+
+TEST(EbnfToBison, test_41) {
+
+  stringstream s(R"%(
+<x> ::= a [b] [c] [d]
+<y> ::= e [f]
+)%");
+
+  Lexer lexer(&s);
+
+  location loc{};
+  BisonParam bisonParam;
+  bisonParam.options.productionBudget = 4;
+
+  EbnfToBison parser([&lexer](location& loc) -> EbnfToBison::symbol_type {
+    return lexer.yylex(loc);
+  },
+  bisonParam,
+  loc);
+
+  EXPECT_EQ(parser(), 0);
+  EXPECT_EQ(bisonParam.stats.numRulesOverBudget, 1);
+
+// only x goes over budget and is factored down to it
+  auto result = bisonParam.namedResult();
+  EXPECT_THAT(result, UnorderedElementsAreArray( (map<string, set<vector<string>>>{
+    {
+      "x",
+      {
+        {"a", "b", "c", "opt_0"},
+        {"a", "b", "opt_0"},
+        {"a", "c", "opt_0"},
+        {"a", "opt_0"},
+      }
+    },
+    {
+      "opt_0",
+      {
+        {},
+        {"d"},
+      }
+    },
+    {
+      "y",
+      {
+        {"e"},
+        {"e", "f"},
+      }
+    },
+  }) ));
+}
+
+TEST(EbnfToBison, test_42) {
+
+  stringstream s(R"%(
+<x> ::= a [b] [c] [d]
+)%");
+
+  Lexer lexer(&s);
+
+  location loc{};
+  BisonParam bisonParam;
+  bisonParam.options.productionBudget = 4;
+  bisonParam.options.refuseOverBudget = true;
+
+  EbnfToBison parser([&lexer](location& loc) -> EbnfToBison::symbol_type {
+    return lexer.yylex(loc);
+  },
+  bisonParam,
+  loc);
+
+  EXPECT_NE(parser(), 0);
+  EXPECT_EQ(bisonParam.stats.numRulesOverBudget, 1);
+  EXPECT_TRUE(bisonParam.result.empty());
+}
+
+
+TEST(EbnfToBison, test_43) {
+
+// rules kept as trees enumerate the same productions with the same helper rules as expanded rules for the GQL grammar
+  auto convert = [](BisonParam& bisonParam) {
+    ifstream s(EBNFTOBISON_DOCS_DIR "/gqlgrammar.quotedliterals.txt");
+    Lexer lexer(&s);
+
+    location loc{};
+    EbnfToBison parser([&lexer](location& loc) -> EbnfToBison::symbol_type {
+      return lexer.yylex(loc);
+    },
+    bisonParam,
+    loc);
+
+    EXPECT_EQ(parser(), 0);
+  };
+
+  BisonParam expanded;
+  convert(expanded);
+
+  BisonParam kept;
+  kept.options.keepTrees = true;
+  convert(kept);
+
+  EXPECT_TRUE(kept.result.empty());
+  EXPECT_EQ(kept.stats.numRulesGenerated, expanded.stats.numRulesGenerated);
+
+  NamedRule enumerated;
+  uint64_t numEnumerated = 0;
+  for(const auto& [ruleName, expr]: kept.ruleTrees) {
+    auto& production = enumerated[kept.symbols.name(ruleName)];
+    ProductionEnumerator productions(expr);
+    for(vector<SymbolId> symbols; productions.next(symbols); ++numEnumerated) {
+      production.insert(kept.symbols.names(symbols));
+    }
+  }
+
+  EXPECT_EQ(enumerated, expanded.namedResult());
+// repeats are counted once like in the expanded rules
+  EXPECT_GE(numEnumerated, expanded.stats.numProductionsGenerated);
+  EXPECT_EQ(kept.stats.numProductionsGenerated, expanded.stats.numProductionsGenerated);
+}
+
+
+TEST(EbnfToBison, test_44) {
+
+// productions of the GQL grammar are allocated from the arena of the parse
+  ifstream s(EBNFTOBISON_DOCS_DIR "/gqlgrammar.quotedliterals.txt");
+  Lexer lexer(&s);
+
+  location loc{};
+  BisonParam bisonParam;
+
+  EbnfToBison parser([&lexer](location& loc) -> EbnfToBison::symbol_type {
+    return lexer.yylex(loc);
+  },
+  bisonParam,
+  loc);
+
+  EXPECT_EQ(parser(), 0);
+
+  auto resource = bisonParam.arena.resource();
+  EXPECT_EQ(bisonParam.result.get_allocator().resource(), resource);
+  for(const auto& [ruleName, production]: bisonParam.result) {
+    EXPECT_EQ(production.get_allocator().resource(), resource);
+  }
+
+  EXPECT_GT(bisonParam.arena.numAllocations(), 100 * bisonParam.arena.numChunks());
+}
+
+
+TEST(EbnfToBison, test_45) {
+
+// errors go to the parser's own diagnostics instead of cerr
+  stringstream s(R"%(
+<x> ::= a ]
+)%");
+
+  Lexer lexer(&s);
+
+  location loc{};
+  BisonParam bisonParam;
+
+  EbnfToBison parser([&lexer](location& loc) -> EbnfToBison::symbol_type {
+    return lexer.yylex(loc);
+  },
+  bisonParam,
+  loc);
+
+  EXPECT_NE(parser(), 0);
+  ASSERT_EQ(bisonParam.diagnostics.size(), 1);
+  EXPECT_THAT(bisonParam.diagnostics.front(), StartsWith("error at inputstream:2."));
+  EXPECT_THAT(bisonParam.diagnostics.front(), HasSubstr("syntax error"));
+}
+
+TEST(EbnfToBison, test_46) {
+
+// parsers on different threads each number their own choice groups from 0 and keep their own diagnostics
+  auto convert = [](const string& grammar, NamedRule& result, vector<string>& diagnostics) {
+    stringstream s(grammar);
+    Lexer lexer(&s);
+
+    location loc{};
+    BisonParam bisonParam;
+
+    EbnfToBison parser([&lexer](location& loc) -> EbnfToBison::symbol_type {
+      return lexer.yylex(loc);
+    },
+    bisonParam,
+    loc);
+
+    parser();
+    result = bisonParam.namedResult();
+    diagnostics = bisonParam.diagnostics;
+  };
+
+  string grammar;
+  {
+    ifstream s(EBNFTOBISON_DOCS_DIR "/gqlgrammar.quotedliterals.txt");
+    grammar.assign(istreambuf_iterator<char>(s), {});
+  }
+  auto badGrammar = "\n<x> ::= {a | b}...\n<y> ::= ]\n"s;
+
+  NamedRule expected;
+  vector<string> expectedDiagnostics;
+  convert(grammar, expected, expectedDiagnostics);
+  ASSERT_TRUE(expectedDiagnostics.empty());
+  ASSERT_TRUE(expected.contains("choice_group_0"));
+
+  const int numThreads = 8;
+  const int numRounds = 4;
+  vector<NamedRule> results(numThreads);
+  vector<vector<string>> diagnostics(numThreads);
+  vector<thread> threads;
+  for(int i = 0; i < numThreads; ++i) {
+    threads.emplace_back([&, i] {
+      NamedRule result;
+      vector<string> threadDiagnostics;
+      for(int round = 0; round < numRounds; ++round) {
+// odd threads alternate with a grammar that fails
+        if(i % 2 == 1 && round % 2 == 0) {
+          convert(badGrammar, result, threadDiagnostics);
+          EXPECT_EQ(threadDiagnostics.size(), 1);
+        } else {
+          convert(grammar, results[i], diagnostics[i]);
+        }
+      }
+    });
+  }
+  for(auto& t: threads) {
+    t.join();
+  }
+
+  for(int i = 0; i < numThreads; ++i) {
+    EXPECT_TRUE(diagnostics[i].empty());
+    EXPECT_EQ(results[i], expected);
+  }
+}
+
+
+TEST(EbnfToBison, test_47) {
+
+// header stays with the first rule, every other shard starts with a rule at the beginning of a line
+  string input = R"%(header line
+<a> ::= x
+  y <b> ::= z
+<c> ::=
+  w
+<d>  ::= v
+)%";
+
+  auto shards = splitAtRules(input, 10);
+  ASSERT_EQ(shards.size(), 3);
+  EXPECT_EQ(shards[0].text, "header line\n<a> ::= x\n  y <b> ::= z\n");
+  EXPECT_EQ(shards[0].firstLine, 1);
+  EXPECT_EQ(shards[1].text, "<c> ::=\n  w\n");
+  EXPECT_EQ(shards[1].firstLine, 4);
+  EXPECT_EQ(shards[2].text, "<d>  ::= v\n");
+  EXPECT_EQ(shards[2].firstLine, 6);
+
+  shards = splitAtRules(input, 1);
+  ASSERT_EQ(shards.size(), 1);
+  EXPECT_EQ(shards[0].text, input);
+}
+
+TEST(EbnfToBison, test_48) {
+
+// sharded conversion of the GQL grammar gives the same rules and counts as one parse
+  string grammar;
+  {
+    ifstream s(EBNFTOBISON_DOCS_DIR "/gqlgrammar.quotedliterals.txt");
+    grammar.assign(istreambuf_iterator<char>(s), {});
+  }
+
+  BisonParam expected;
+  expected.options.factorThreshold = 4;
+  {
+    stringstream s(grammar);
+    Lexer lexer(&s);
+    location loc{};
+    EbnfToBison parser([&lexer](location& loc) -> EbnfToBison::symbol_type {
+      return lexer.yylex(loc);
+    },
+    expected,
+    loc);
+    ASSERT_EQ(parser(), 0);
+  }
+
+  for(size_t numThreads: {1, 3, 8}) {
+    BisonParam bisonParam;
+    bisonParam.options.factorThreshold = 4;
+    ASSERT_EQ(convertSharded(grammar, nullptr, bisonParam, numThreads), 0);
+    EXPECT_EQ(bisonParam.namedResult(), expected.namedResult());
+    EXPECT_EQ(bisonParam.stats.numRulesParsed, expected.stats.numRulesParsed);
+    EXPECT_EQ(bisonParam.stats.numRulesGenerated, expected.stats.numRulesGenerated);
+    EXPECT_EQ(bisonParam.stats.numProductionsGenerated, expected.stats.numProductionsGenerated);
+    EXPECT_EQ(bisonParam.stats.numOptionalsFactored, expected.stats.numOptionalsFactored);
+    EXPECT_EQ(bisonParam.stats.numGroupsFactored, expected.stats.numGroupsFactored);
+  }
+}
+
+TEST(EbnfToBison, test_49) {
+
+// choice groups 9 and 10 are 0 and 1 in the last shard, list names made from them are rebuilt in the name order of their final numbers
+  string grammar;
+  for(int i = 0; i < 9; ++i) {
+    grammar += "<r" + to_string(i) + "> ::= {a | b}...\n";
+  }
+  grammar += "<z> ::= {x [{c | d}...] [{e | f}...]}...\n";
+
+  BisonParam expected;
+  {
+    stringstream s(grammar);
+    Lexer lexer(&s);
+    location loc{};
+    EbnfToBison parser([&lexer](location& loc) -> EbnfToBison::symbol_type {
+      return lexer.yylex(loc);
+    },
+    expected,
+    loc);
+    ASSERT_EQ(parser(), 0);
+  }
+  ASSERT_TRUE(expected.namedResult().contains("x_listx_choice_group_10_list_list"));
+
+  BisonParam bisonParam;
+  ASSERT_EQ(convertSharded(grammar, nullptr, bisonParam, 8), 0);
+  EXPECT_EQ(bisonParam.namedResult(), expected.namedResult());
+  EXPECT_EQ(bisonParam.stats.numChoiceGroups, 11);
+
+// errors come from every shard that failed, in input order, at their lines in the whole input
+  BisonParam failed;
+  EXPECT_NE(convertSharded(grammar + "<y> ::= ]\n", nullptr, failed, 8), 0);
+  ASSERT_EQ(failed.diagnostics.size(), 1);
+  EXPECT_THAT(failed.diagnostics.front(), HasSubstr(":11."));
+  EXPECT_TRUE(failed.result.empty());
+}
+
+TEST(EbnfToBison, test_50) {
+
+// a rule of 16 optionals is joined on the expansion pool, rules come out the same as expanding on one thread
+  string grammar = "<r> ::=";
+  for(int i = 0; i < 16; ++i) {
+    grammar += " [t" + to_string(i) + "]";
+  }
+  grammar += " {a | b}...\n";
+
+  auto convert = [&grammar](BisonParam& bisonParam) {
+    stringstream s(grammar);
+    Lexer lexer(&s);
+    location loc{};
+    EbnfToBison parser([&lexer](location& loc) -> EbnfToBison::symbol_type {
+      return lexer.yylex(loc);
+    },
+    bisonParam,
+    loc);
+    return parser();
+  };
+
+  BisonParam expected;
+  ASSERT_EQ(convert(expected), 0);
+  EXPECT_EQ(expected.stats.numExpandTasks, 0);
+
+  BisonParam bisonParam;
+  bisonParam.options.expandThreads = 4;
+  ASSERT_EQ(convert(bisonParam), 0);
+  EXPECT_EQ(bisonParam.namedResult(), expected.namedResult());
+  EXPECT_EQ(bisonParam.stats.numProductionsGenerated, expected.stats.numProductionsGenerated);
+  EXPECT_EQ(bisonParam.sequences.size(), expected.sequences.size());
+  EXPECT_GT(bisonParam.stats.numExpandTasks, 0);
+  EXPECT_LE(bisonParam.stats.maxExpandTaskTime, bisonParam.stats.expandTaskTime);
+}
+
+TEST(EbnfToBison, test_51) {
+
+// tokens passed from a lexer thread convert to the same rules and report errors at the same place
+  string grammar;
+  {
+    ifstream s(EBNFTOBISON_DOCS_DIR "/gqlgrammar.quotedliterals.txt");
+    grammar.assign(istreambuf_iterator<char>(s), {});
+  }
+
+  auto convert = [](const string& grammar, bool pipelined, BisonParam& bisonParam) {
+    Lexer lexer;
+    lexer.switch_buffer(grammar);
+    PipelinedLexer pipelinedLexer([&lexer](location& loc) { return lexer.yylex(loc); }, 16);
+    location loc{};
+    EbnfToBison parser([&](location& loc) -> EbnfToBison::symbol_type {
+      return pipelined? pipelinedLexer.yylex(loc): lexer.yylex(loc);
+    },
+    bisonParam,
+    loc);
+    return parser();
+  };
+
+  BisonParam expected;
+  ASSERT_EQ(convert(grammar, false, expected), 0);
+  BisonParam bisonParam;
+  ASSERT_EQ(convert(grammar, true, bisonParam), 0);
+  EXPECT_EQ(bisonParam.namedResult(), expected.namedResult());
+
+// parser stops at the syntax error while the lexer thread may already be waiting to push more
+  grammar.insert(grammar.find("\n<character string literal> ::=") + 1, "<bad> ::= a ]\n");
+  BisonParam expectedError;
+  EXPECT_NE(convert(grammar, false, expectedError), 0);
+  BisonParam error;
+  EXPECT_NE(convert(grammar, true, error), 0);
+  EXPECT_EQ(error.diagnostics, expectedError.diagnostics);
+  EXPECT_EQ(error.diagnostics.size(), 1);
+}
+
+TEST(EbnfToBison, test_52) {
+
+// grammar fed in chunks of random size converts the same as in one piece
+  auto readFile = [](const string& filename) {
+    ifstream s(filename);
+    return string(istreambuf_iterator<char>(s), {});
+  };
+  auto convert = [](const string& grammar, BisonParam& bisonParam) {
+    stringstream s(grammar);
+    Lexer lexer(&s);
+    location loc{};
+    EbnfToBison parser([&lexer](location& loc) -> EbnfToBison::symbol_type {
+      return lexer.yylex(loc);
+    },
+    bisonParam,
+    loc);
+    return parser();
+  };
+  auto convertInChunks = [](const string& grammar, BisonParam& bisonParam, size_t minPieceSize, unsigned seed) {
+    IncrementalConverter converter(bisonParam, nullptr, false, minPieceSize);
+    mt19937 random(seed);
+    uniform_int_distribution<size_t> chunkSize(1, 4096);
+    for(size_t i = 0; i < grammar.size();) {
+      auto n = min(chunkSize(random), grammar.size() - i);
+      if(auto ev = converter.feed(grammar.data() + i, n); ev != 0) {
+        return ev;
+      }
+      i += n;
+    }
+    return converter.finish();
+  };
+
+  auto grammar = readFile(EBNFTOBISON_DOCS_DIR "/gqlgrammar.quotedliterals.txt");
+  BisonParam expected;
+  ASSERT_EQ(convert(grammar, expected), 0);
+
+// a piece per rule, then pieces of at least 16k
+  for(size_t minPieceSize: {1, 16384}) {
+    for(unsigned seed = 0; seed < 3; ++seed) {
+      BisonParam bisonParam;
+      ASSERT_EQ(convertInChunks(grammar, bisonParam, minPieceSize, seed), 0);
+      EXPECT_EQ(bisonParam.namedResult(), expected.namedResult());
+      EXPECT_EQ(bisonParam.stats.numRulesParsed, expected.stats.numRulesParsed);
+      EXPECT_EQ(bisonParam.stats.numRulesGenerated, expected.stats.numRulesGenerated);
+      EXPECT_EQ(bisonParam.stats.numProductionsGenerated, expected.stats.numProductionsGenerated);
+      EXPECT_EQ(bisonParam.stats.numChoiceGroups, expected.stats.numChoiceGroups);
+    }
+  }
+
+// grammar with unquoted literals fails with the same error at the same line
+  auto unquoted = readFile(EBNFTOBISON_DOCS_DIR "/gqlgrammar.txt");
+  BisonParam expectedError;
+  ASSERT_NE(convert(unquoted, expectedError), 0);
+  ASSERT_EQ(expectedError.diagnostics.size(), 1);
+  for(unsigned seed = 0; seed < 3; ++seed) {
+    BisonParam bisonParam;
+    EXPECT_NE(convertInChunks(unquoted, bisonParam, 1, seed), 0);
+    EXPECT_EQ(bisonParam.diagnostics, expectedError.diagnostics);
+    EXPECT_TRUE(bisonParam.result.empty());
+  }
+}
+
+TEST(EbnfToBison, test_53) {
+
+// rules loaded from the cache merge the same as rules parsed, helper names after an edited rule are renumbered
+  auto convert = [](const string& grammar, BisonParam& bisonParam) {
+    stringstream s(grammar);
+    Lexer lexer(&s);
+    location loc{};
+    EbnfToBison parser([&lexer](location& loc) -> EbnfToBison::symbol_type {
+      return lexer.yylex(loc);
+    },
+    bisonParam,
+    loc);
+    return parser();
+  };
+  auto dir = filesystem::temp_directory_path() / ("ebnftobison_rule_cache_test_" + to_string(getpid()));
+  filesystem::remove_all(dir);
+  RuleCache cache(dir.string());
+
+  string grammar = "header line\n";
+  for(int i = 0; i < 9; ++i) {
+    grammar += "<r" + to_string(i) + "> ::= {a | b}... [c] [d | e]\n";
+  }
+  grammar += "<z> ::= {x [{c | d}...] [{e | f}...]}...\n";
+
+  auto check = [&](const string& grammar, uint64_t numHits, uint64_t numMisses) {
+    BisonParam expected;
+    expected.options.factorThreshold = 2;
+    ASSERT_EQ(convert(grammar, expected), 0);
+    BisonParam bisonParam;
+    bisonParam.options.factorThreshold = 2;
+    ASSERT_EQ(convertCached(grammar, nullptr, bisonParam, cache, 3), 0);
+    EXPECT_EQ(bisonParam.namedResult(), expected.namedResult());
+    EXPECT_EQ(bisonParam.predictedSizes.size(), expected.predictedSizes.size());
+    EXPECT_EQ(bisonParam.stats.numRulesParsed, expected.stats.numRulesParsed);
+    EXPECT_EQ(bisonParam.stats.numOptionalsFactored, expected.stats.numOptionalsFactored);
+    EXPECT_EQ(bisonParam.stats.numGroupsFactored, expected.stats.numGroupsFactored);
+    EXPECT_EQ(bisonParam.stats.numChoiceGroups, expected.stats.numChoiceGroups);
+    EXPECT_EQ(bisonParam.stats.numRuleCacheHits, numHits);
+    EXPECT_EQ(bisonParam.stats.numRuleCacheMisses, numMisses);
+  };
+
+  check(grammar, 0, 10);
+  check(grammar, 10, 0);
+
+// trailing blanks, empty lines and a different header don't change the text a rule is stored under
+  auto reformatted = grammar;
+  reformatted.replace(0, 11, "other header\n\n");
+  reformatted.replace(reformatted.find("<r4>"), 4, "\n<r4>");
+  reformatted.replace(reformatted.find("\n<z>"), 1, "  \r\n");
+  check(reformatted, 10, 0);
+
+// a choice group added to an early rule moves every helper number after it
+  auto edited = grammar;
+  edited.replace(edited.find("<r1> ::= "), 9, "<r1> ::= {g | h}... ");
+  check(edited, 9, 1);
+  check(edited, 10, 0);
+
+// other options are stored under other keys
+  BisonParam distributed;
+  ASSERT_EQ(convertCached(grammar, nullptr, distributed, cache), 0);
+  EXPECT_EQ(distributed.stats.numRuleCacheMisses, 10);
+
+// a damaged entry is a miss and is stored again
+  auto key = RuleCache::key(RuleCache::normalizedText("<r8> ::= {a | b}... [c] [d | e]\n"), {.factorThreshold = 2});
+  filesystem::resize_file(dir / (key + ".rule"), 40);
+  check(grammar, 9, 1);
+  check(grammar, 10, 0);
+
+// so is one with a count far past its size, which would have been allocated before it was read
+  auto zKey = RuleCache::key(RuleCache::normalizedText("<z> ::= {x [{c | d}...] [{e | f}...]}...\n"), {.factorThreshold = 2});
+  string entry;
+  {
+    ifstream in(dir / (zKey + ".rule"));
+    entry.assign(istreambuf_iterator<char>(in), {});
+  }
+  auto helper = entry.find("\n7 0 0 0 1\n");
+  ASSERT_NE(helper, string::npos);
+  entry.replace(helper, 11, "\n7 0 0 0 1000000000000\n");
+  ofstream(dir / (zKey + ".rule")) << entry;
+  check(grammar, 9, 1);
+  check(grammar, 10, 0);
+
+// rules that fail aren't stored
+  BisonParam failed;
+  EXPECT_NE(convertCached(grammar + "<y> ::= ]\n", nullptr, failed, cache), 0);
+  ASSERT_EQ(failed.diagnostics.size(), 1);
+  EXPECT_THAT(failed.diagnostics.front(), HasSubstr(":12."));
+  EXPECT_TRUE(failed.result.empty());
+  BisonParam failedAgain;
+  EXPECT_NE(convertCached(grammar + "<y> ::= ]\n", nullptr, failedAgain, cache), 0);
+  EXPECT_EQ(failedAgain.stats.numRuleCacheMisses, 1);
+
+  filesystem::remove_all(dir);
+}
+
+}
@@ -0,0 +1,475 @@
+// ebnftobison_rule_cache.cpp
+
+/*
+MIT License
+
+Copyright (c) 2024 Zartaj Majeed
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <cstdio>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <system_error>
+#include <thread>
+
+#include "parser/ebnftobison_rule_cache.h"
+#include "parser/ebnftobison_sharded.h"
+#include "lexer/ebnftobison_mapped_file.h"
+
+namespace ebnftobison {
+
+// an entry is lines of text, numbers are separated by spaces and every symbol name is on a line of its own
+// ebnftobison rule cache <version>
+// text <bytes> followed by the normalized text of the rule
+// counters <rules parsed> <optionals factored> <groups factored> <choice groups> <rules over budget>
+// symbols <n> followed by n names, a symbol's id is its line
+// helpers <n> followed by <id> <counter> <number> <last> <sequences> and a line of <size> <ids> for each sequence
+// predictions <n> followed by <id> <productions> <symbols> <list productions>
+// rules <n> followed by <id> <productions> and a line of <size> <ids> for each production
+// end
+
+namespace {
+
+class EntryWriter {
+public:
+
+  explicit EntryWriter(string& out): out(out) {}
+
+  EntryWriter& operator<<(string_view s) {
+    out += s;
+    return *this;
+  }
+
+  EntryWriter& operator<<(uint64_t n) {
+    char buf[24];
+    auto [end, ec] = to_chars(buf, buf + sizeof buf, n);
+    out.append(buf, end);
+    return *this;
+  }
+
+  void symbols(const vector<SymbolId>& v) {
+    *this << v.size();
+    for(auto id: v) {
+      *this << " " << id;
+    }
+    *this << "\n";
+  }
+
+private:
+
+  string& out;
+
+};
+
+// reads an entry back, any mismatch leaves ok false and the entry is treated as missing
+class EntryReader {
+public:
+
+  explicit EntryReader(string_view in): in(in) {}
+
+  bool ok = true;
+
+  void expect(string_view word) {
+    skipBlanks();
+    if(in.substr(pos, word.size()) != word) {
+      ok = false;
+      return;
+    }
+    pos += word.size();
+  }
+
+  uint64_t number() {
+    skipBlanks();
+    uint64_t n = 0;
+    auto [end, ec] = from_chars(in.data() + pos, in.data() + in.size(), n);
+    if(ec != errc{}) {
+      ok = false;
+      return 0;
+    }
+    pos = end - in.data();
+    return n;
+  }
+
+// every counted item takes at least a byte so a count past the bytes left is a corrupted entry, not a reason to allocate
+  uint64_t count() {
+    auto n = number();
+    if(n > in.size() - pos) {
+      ok = false;
+      return 0;
+    }
+    return n;
+  }
+
+// symbol ids are checked against the symbols read so a bad entry can't index past them
+  SymbolId symbol(size_t numSymbols) {
+    auto id = number();
+    if(id >= numSymbols) {
+      ok = false;
+      return 0;
+    }
+    return static_cast<SymbolId>(id);
+  }
+
+  void symbols(size_t numSymbols, vector<SymbolId>& v) {
+    v.clear();
+    for(auto n = count(); ok && n > 0; --n) {
+      v.push_back(symbol(numSymbols));
+    }
+  }
+
+// rest of the current line after the newline that ends the line before it
+  string_view line() {
+    endLine();
+    auto end = in.find('\n', pos);
+    if(end == string_view::npos) {
+      ok = false;
+      return {};
+    }
+    auto s = in.substr(pos, end - pos);
+    pos = end;
+    return s;
+  }
+
+  string_view bytes(size_t n) {
+    endLine();
+    if(in.size() - pos < n) {
+      ok = false;
+      return {};
+    }
+    auto s = in.substr(pos, n);
+    pos += n;
+    return s;
+  }
+
+private:
+
+  void skipBlanks() {
+    while(pos < in.size() && (in[pos] == ' ' || in[pos] == '\n')) {
+      ++pos;
+    }
+  }
+
+  void endLine() {
+    if(pos < in.size() && in[pos] == '\n') {
+      ++pos;
+    } else {
+      ok = false;
+    }
+  }
+
+  string_view in;
+  size_t pos = 0;
+
+};
+
+}
+
+string RuleCache::normalizedText(string_view text) {
+  size_t i = 0;
+  while(i < text.size() && !isRuleStart(text, i)) {
+    auto lineEnd = text.find('\n', i);
+    i = lineEnd == string_view::npos? text.size(): lineEnd + 1;
+  }
+
+  string normalized;
+  normalized.reserve(text.size() - i);
+  while(i < text.size()) {
+    auto lineEnd = min(text.find('\n', i), text.size());
+    auto line = text.substr(i, lineEnd - i);
+    auto last = line.find_last_not_of(" \t\v\f\r");
+    if(last != string_view::npos) {
+      normalized.append(line.substr(0, last + 1));
+      normalized += '\n';
+    }
+    i = lineEnd + 1;
+  }
+  return normalized;
+}
+
+// 64 bit FNV-1a, a hash collision is caught when the stored text doesn't match
+string RuleCache::key(string_view normalizedText, const BisonParam::Options& options) {
+  uint64_t hash = 14695981039346656037ull;
+  auto add = [&hash](string_view s) {
+    for(unsigned char c: s) {
+      hash = (hash ^ c) * 1099511628211ull;
+    }
+  };
+  string fingerprint;
+  EntryWriter(fingerprint) << version << " " << options.factorThreshold << " " << options.productionBudget << " " << uint64_t{options.refuseOverBudget} << "\n";
+  add(fingerprint);
+  add(normalizedText);
+
+  string key(16, '0');
+  auto [end, ec] = to_chars(key.data(), key.data() + key.size(), hash, 16);
+  rotate(key.begin(), key.begin() + (end - key.data()), key.end());
+  return key;
+}
+
+shared_ptr<const BisonParam> RuleCache::find(const string& key, string_view normalizedText) const {
+  if(auto i = kept.find(key); i != kept.end() && i->second.text == normalizedText) {
+    return i->second.rule;
+  }
+  if(dir.empty()) {
+    return nullptr;
+  }
+  auto shard = make_shared<BisonParam>();
+  if(!load(key, normalizedText, *shard)) {
+    return nullptr;
+  }
+  return shard;
+}
+
+string RuleCache::path(const string& key) const {
+  return (filesystem::path(dir) / (key + ".rule")).string();
+}
+
+bool RuleCache::load(const string& key, string_view normalizedText, BisonParam& shard) const {
+  MappedFile file;
+  if(!file.open(path(key))) {
+    return false;
+  }
+  EntryReader in(file.contents());
+
+  in.expect("ebnftobison rule cache");
+  if(in.number() != version) {
+    return false;
+  }
+  in.expect("text");
+  auto textSize = in.number();
+  if(!in.ok || in.bytes(textSize) != normalizedText) {
+    return false;
+  }
+
+  auto& stats = shard.stats;
+  in.expect("counters");
+  stats.numRulesParsed = in.number();
+  stats.numOptionalsFactored = in.number();
+  stats.numGroupsFactored = in.number();
+  stats.numChoiceGroups = in.number();
+  stats.numRulesOverBudget = in.number();
+
+// names are interned in id order so every symbol gets back the id it was stored with
+  in.expect("symbols");
+  for(auto n = in.count(); in.ok && n > 0; --n) {
+    shard.symbols.intern(in.line());
+  }
+  auto numSymbols = shard.symbols.size();
+
+  in.expect("helpers");
+  for(auto n = in.count(); in.ok && n > 0; --n) {
+    auto id = in.symbol(numSymbols);
+    auto& helperName = shard.helperNames[id];
+    auto counter = in.number();
+    if(counter > static_cast<uint64_t>(HelperName::Counter::choiceGroup)) {
+      return false;
+    }
+    helperName.counter = static_cast<HelperName::Counter>(counter);
+    helperName.number = in.number();
+    helperName.last = in.number();
+    auto numSequences = in.count();
+    if(helperName.counter == HelperName::Counter::none) {
+      if(!in.ok || helperName.last >= numSequences) {
+        return false;
+      }
+      auto sequences = make_shared<vector<vector<SymbolId>>>(numSequences);
+      for(auto& v: *sequences) {
+        in.symbols(numSymbols, v);
+      }
+      helperName.sequences = std::move(sequences);
+    }
+  }
+
+  in.expect("predictions");
+  for(auto n = in.count(); in.ok && n > 0; --n) {
+    auto& size = shard.predictedSizes[in.symbol(numSymbols)];
+    size.numProductions = in.number();
+    size.numSymbols = in.number();
+    size.numListProductions = in.number();
+  }
+
+  in.expect("rules");
+  vector<SymbolId> symbols;
+  for(auto n = in.count(); in.ok && n > 0; --n) {
+    auto ruleName = in.symbol(numSymbols);
+    Production production(shard.arena.resource());
+    for(auto m = in.count(); in.ok && m > 0; --m) {
+      in.symbols(numSymbols, symbols);
+      production.push_back(shard.sequences.intern(symbols));
+    }
+    shard.result.emplace(ruleName, std::move(production));
+  }
+
+  in.expect("end");
+  return in.ok;
+}
+
+bool RuleCache::store(const string& key, string_view normalizedText, const BisonParam& shard) const {
+  string entry;
+  EntryWriter out(entry);
+  const auto& stats = shard.stats;
+  out << "ebnftobison rule cache " << version << "\n";
+  out << "text " << normalizedText.size() << "\n" << normalizedText << "\n";
+  out << "counters " << stats.numRulesParsed << " " << stats.numOptionalsFactored << " " << stats.numGroupsFactored << " " << stats.numChoiceGroups << " " << stats.numRulesOverBudget << "\n";
+
+  out << "symbols " << shard.symbols.size() << "\n";
+  for(SymbolId id = 0; id < shard.symbols.size(); ++id) {
+    out << shard.symbols.name(id) << "\n";
+  }
+
+  out << "helpers " << shard.helperNames.size() << "\n";
+  for(const auto& [id, helperName]: shard.helperNames) {
+    auto numSequences = helperName.sequences? helperName.sequences->size(): 0;
+    out << id << " " << static_cast<uint64_t>(helperName.counter) << " " << helperName.number << " " << helperName.last << " " << numSequences << "\n";
+    if(helperName.sequences) {
+      for(const auto& v: *helperName.sequences) {
+        out.symbols(v);
+      }
+    }
+  }
+
+  out << "predictions " << shard.predictedSizes.size() << "\n";
+  for(const auto& [id, size]: shard.predictedSizes) {
+    out << id << " " << size.numProductions << " " << size.numSymbols << " " << size.numListProductions << "\n";
+  }
+
+  out << "rules " << shard.result.size() << "\n";
+  vector<SymbolId> symbols;
+  for(const auto& [ruleName, production]: shard.result) {
+    out << ruleName << " " << production.size() << "\n";
+    for(auto id: production) {
+      symbols.clear();
+      shard.sequences.appendSymbols(id, symbols);
+      out.symbols(symbols);
+    }
+  }
+  out << "end\n";
+
+// writers of the same rule on other threads or processes each have a temporary file of their own
+  auto entryPath = path(key);
+  auto temporary = entryPath + ".tmp." + to_string(getpid()) + "." + to_string(hash<thread::id>{}(this_thread::get_id()));
+  auto file = fopen(temporary.c_str(), "w");
+  if(file == nullptr) {
+    return false;
+  }
+  auto written = fwrite(entry.data(), 1, entry.size(), file) == entry.size();
+  written = fclose(file) == 0 && written;
+  if(!written || rename(temporary.c_str(), entryPath.c_str()) != 0) {
+    remove(temporary.c_str());
+    return false;
+  }
+  return true;
+}
+
+int convertCached(string_view input, const string* filename, BisonParam& bisonParam, RuleCache& cache, size_t numThreads, bool useSimdLexer) {
+  auto startTime = steady_clock::now();
+
+// one rule to a piece, the first also has the header
+  auto pieces = splitAtRules(input, input.size() + 1);
+  vector<shared_ptr<const BisonParam>> pieceParams(pieces.size());
+  vector<int> results(pieces.size());
+  vector<string> texts(pieces.size());
+  vector<string> keys(pieces.size());
+  vector<size_t> misses;
+
+  for(size_t k = 0; k < pieces.size(); ++k) {
+    texts[k] = RuleCache::normalizedText(pieces[k].text);
+    keys[k] = RuleCache::key(texts[k], bisonParam.options);
+    pieceParams[k] = cache.find(keys[k], texts[k]);
+    if(!pieceParams[k]) {
+      misses.push_back(k);
+    }
+  }
+
+  auto storing = !cache.directory().empty();
+  if(storing && !misses.empty()) {
+    error_code ec;
+    filesystem::create_directories(cache.directory(), ec);
+  }
+
+  atomic<size_t> nextMiss{0};
+  auto work = [&] {
+    for(size_t m; (m = nextMiss++) < misses.size();) {
+      auto k = misses[m];
+      auto pieceParam = make_shared<BisonParam>();
+      results[k] = parseShard(pieces[k], filename, bisonParam.options, useSimdLexer, *pieceParam);
+      if(results[k] == 0 && storing) {
+        cache.store(keys[k], texts[k], *pieceParam);
+      }
+      pieceParams[k] = std::move(pieceParam);
+    }
+  };
+
+  vector<thread> threads;
+  for(size_t i = 1; i < min(numThreads, misses.size()); ++i) {
+    threads.emplace_back(work);
+  }
+  work();
+  for(auto& t: threads) {
+    t.join();
+  }
+
+// rules that parsed are kept even when others failed so fixing those parses only them
+  if(cache.keepsRules()) {
+    unordered_map<string, RuleCache::KeptRule> kept;
+    for(size_t k = 0; k < pieces.size(); ++k) {
+      if(results[k] == 0) {
+        kept.try_emplace(keys[k], RuleCache::KeptRule{.text = std::move(texts[k]), .rule = pieceParams[k]});
+      }
+    }
+    cache.keep(std::move(kept));
+  }
+
+  auto& stats = bisonParam.stats;
+  stats = {};
+  stats.parseStartTime = startTime;
+  stats.numRuleCacheHits = pieces.size() - misses.size();
+  stats.numRuleCacheMisses = misses.size();
+  bisonParam.diagnostics.clear();
+  auto ev = 0;
+  for(size_t k = 0; k < pieces.size(); ++k) {
+    if(results[k] != 0) {
+      ev = results[k];
+      ranges::copy(pieceParams[k]->diagnostics, back_inserter(bisonParam.diagnostics));
+    }
+  }
+  if(ev != 0) {
+    bisonParam.result.clear();
+    return ev;
+  }
+
+  BisonParam::Stats offsets;
+  for(const auto& pieceParam: pieceParams) {
+    mergeShard(bisonParam, *pieceParam, offsets);
+  }
+  setMergedCounts(stats, offsets);
+
+  stats.parseEndTime = steady_clock::now();
+  stats.parseTimeTakenSec = stats.parseEndTime - stats.parseStartTime;
+  return 0;
+}
+
+}
@@ -0,0 +1,103 @@
+#ifndef EBNFTOBISON_RULE_CACHE_H
+#define EBNFTOBISON_RULE_CACHE_H
+// ebnftobison_rule_cache.h
+
+/*
+MIT License
+
+Copyright (c) 2024 Zartaj Majeed
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#include "ebnftobison.bison.h"
+
+namespace ebnftobison {
+using namespace std;
+
+// converted rules kept in files of a directory so converting a grammar again only parses the rules that changed
+// every rule is converted on its own like a shard of one rule and stored under a hash of its text and the options
+// rules from the cache are merged like shards, so helper names like choice_group_N are the same whether a rule was converted or loaded
+// with keepRules the rules of the last conversion are kept in memory too, for a process that converts the same grammar over and over
+class RuleCache {
+public:
+
+// bumped whenever the entry layout or the conversion changes so old entries are never read
+  static constexpr unsigned version = 1;
+
+  struct KeptRule {
+    string text;
+    shared_ptr<const BisonParam> rule;
+  };
+
+// directory may be empty for rules kept only in memory
+  explicit RuleCache(string directory, bool keepRules = false): dir(std::move(directory)), keepRules(keepRules) {}
+
+// text of a rule with trailing blanks and empty lines dropped, they don't change the conversion
+// any header before the first rule is dropped too
+  static string normalizedText(string_view text);
+
+// hex hash of normalized text and the options that change the conversion, also the name of the rule's file
+  static string key(string_view normalizedText, const BisonParam::Options& options);
+
+// rule stored under key from memory or else from the directory, nullptr when there is none or it doesn't hold normalizedText
+  shared_ptr<const BisonParam> find(const string& key, string_view normalizedText) const;
+
+// fills a fresh shard with the rule stored under key in the directory, false when there is none or it doesn't hold normalizedText
+  bool load(const string& key, string_view normalizedText, BisonParam& shard) const;
+
+// writes a parsed shard under key, the file is renamed into place so readers never see part of it
+  bool store(const string& key, string_view normalizedText, const BisonParam& shard) const;
+
+// rules of one conversion by key, they replace the rules kept from the conversion before when keepRules is set
+  void keep(unordered_map<string, KeptRule>&& rules) {
+    if(keepRules) {
+      kept = std::move(rules);
+    }
+  }
+
+  const string& directory() const { return dir; }
+
+  bool keepsRules() const { return keepRules; }
+
+private:
+
+  string path(const string& key) const;
+
+  string dir;
+  bool keepRules;
+  unordered_map<string, KeptRule> kept;
+
+};
+
+// converts input a rule at a time, rules found in cache are reused and the rest are parsed on numThreads threads and stored
+// merged rules and helper names are the same as parsing input in one piece, hits and misses are counted in the stats of bisonParam
+// bisonParam gives the options for every rule, keepTrees and ruleSink aren't supported
+// returns 0 on success like the parser, rules that fail to parse aren't stored
+int convertCached(string_view input, const string* filename, BisonParam& bisonParam, RuleCache& cache, size_t numThreads = 1, bool useSimdLexer = false);
+
+}
+
+#endif
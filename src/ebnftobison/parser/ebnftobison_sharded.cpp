@@ -0,0 +1,287 @@
+// ebnftobison_sharded.cpp
+
+/*
+MIT License
+
+Copyright (c) 2024 Zartaj Majeed
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <thread>
+
+#include "parser/ebnftobison_sharded.h"
+#include "lexer/ebnftobison_lexer.h"
+#include "lexer/ebnftobison_simd_lexer.h"
+
+namespace ebnftobison {
+
+namespace {
+
+bool isNameChar(char c) {
+  return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '-' || c == ' ' || c == '_' || c == '/';
+}
+
+}
+
+bool isRuleStart(string_view input, size_t i) {
+  if(i >= input.size() || input[i] != '<') {
+    return false;
+  }
+  auto j = i + 1;
+  while(j < input.size() && isNameChar(input[j])) {
+    ++j;
+  }
+  if(j == i + 1 || j >= input.size() || input[j] != '>') {
+    return false;
+  }
+  ++j;
+  while(j < input.size() && input[j] == ' ') {
+    ++j;
+  }
+  return input.substr(j, 3) == "::=";
+}
+
+namespace {
+
+// names of one shard's symbols in the merged symbol table, helper names are rebuilt with counters offset by earlier shards
+class ShardMerger {
+public:
+
+  ShardMerger(BisonParam& merged, const BisonParam& shard, const BisonParam::Stats& offsets): merged(merged), shard(shard), offsets(offsets), globalIds(shard.symbols.size(), unknown) {}
+
+  SymbolId global(SymbolId local);
+
+  vector<SymbolId> global(const vector<SymbolId>& local) {
+    vector<SymbolId> v;
+    v.reserve(local.size());
+    for(auto id: local) {
+      v.push_back(global(id));
+    }
+    return v;
+  }
+
+  void merge();
+
+private:
+
+  string helperName(const HelperName& helperName);
+
+  static constexpr SymbolId unknown = ~SymbolId{};
+
+  BisonParam& merged;
+  const BisonParam& shard;
+  const BisonParam::Stats& offsets;
+  vector<SymbolId> globalIds;
+
+};
+
+SymbolId ShardMerger::global(SymbolId local) {
+  if(globalIds[local] != unknown) {
+    return globalIds[local];
+  }
+  auto i = shard.helperNames.find(local);
+  auto id = i == shard.helperNames.end()? merged.symbols.intern(shard.symbols.name(local)): merged.symbols.intern(helperName(i->second));
+  globalIds[local] = id;
+  return id;
+}
+
+// list names depend on the name order of their sequences, which can change once numbers in helper names are offset
+string ShardMerger::helperName(const HelperName& helperName) {
+  switch(helperName.counter) {
+  case HelperName::Counter::optional:
+    return BisonParam::counterName(helperName.counter, offsets.numOptionalsFactored + helperName.number);
+  case HelperName::Counter::group:
+    return BisonParam::counterName(helperName.counter, offsets.numGroupsFactored + helperName.number);
+  case HelperName::Counter::choiceGroup:
+    return BisonParam::counterName(helperName.counter, offsets.numChoiceGroups + helperName.number);
+  case HelperName::Counter::none:
+    break;
+  }
+  vector<vector<SymbolId>> sequences;
+  for(const auto& v: *helperName.sequences) {
+    sequences.push_back(global(v));
+  }
+  auto last = sequences[helperName.last];
+  ranges::sort(sequences, [this](const vector<SymbolId>& a, const vector<SymbolId>& b) { return merged.symbols.less(a, b); });
+  string name;
+  for(const auto& v: sequences) {
+    merged.appendListRuleName(name, v);
+    if(v == last) {
+      break;
+    }
+  }
+  return name;
+}
+
+// rules are added in shard order so the first definition of a rule wins like it does in one parse
+void ShardMerger::merge() {
+  for(const auto& [ruleName, predictedSize]: shard.predictedSizes) {
+    merged.predictedSizes[global(ruleName)] = predictedSize;
+  }
+  vector<SymbolId> symbols;
+  for(const auto& [ruleName, production]: shard.result) {
+    Production mergedProduction(merged.arena.resource());
+    mergedProduction.reserve(production.size());
+    for(auto id: production) {
+      symbols.clear();
+      shard.sequences.appendSymbols(id, symbols);
+      for(auto& symbol: symbols) {
+        symbol = global(symbol);
+      }
+      mergedProduction.push_back(merged.sequences.intern(symbols));
+    }
+    merged.addRule(global(ruleName), std::move(mergedProduction));
+  }
+}
+
+}
+
+int parseShard(const Shard& shard, const string* filename, const BisonParam::Options& options, bool useSimdLexer, BisonParam& shardParam) {
+  shardParam.options = options;
+  shardParam.options.keepTrees = false;
+  shardParam.options.recordHelperNames = true;
+
+  location loc(filename, shard.firstLine);
+  Lexer lexer;
+  SimdLexer simdLexer;
+  if(useSimdLexer) {
+    simdLexer.switch_buffer(shard.text);
+  } else {
+    lexer.switch_buffer(shard.text);
+  }
+  EbnfToBison parser([&](location& loc) -> EbnfToBison::symbol_type {
+    return useSimdLexer? simdLexer.yylex(loc): lexer.yylex(loc);
+  },
+  shardParam,
+  loc);
+  return parser();
+}
+
+void mergeShard(BisonParam& merged, const BisonParam& shard, BisonParam::Stats& offsets) {
+  ShardMerger(merged, shard, offsets).merge();
+  const auto& shardStats = shard.stats;
+  offsets.numRulesParsed += shardStats.numRulesParsed;
+  offsets.numOptionalsFactored += shardStats.numOptionalsFactored;
+  offsets.numGroupsFactored += shardStats.numGroupsFactored;
+  offsets.numChoiceGroups += shardStats.numChoiceGroups;
+  offsets.numRulesOverBudget += shardStats.numRulesOverBudget;
+  offsets.numExpandTasks += shardStats.numExpandTasks;
+  offsets.numExpandTasksStolen += shardStats.numExpandTasksStolen;
+  offsets.expandTaskTime += shardStats.expandTaskTime;
+  offsets.maxExpandTaskTime = max(offsets.maxExpandTaskTime, shardStats.maxExpandTaskTime);
+}
+
+// rules and productions generated are counted by addRule as shards are merged
+void setMergedCounts(BisonParam::Stats& stats, const BisonParam::Stats& offsets) {
+  stats.numRulesParsed = offsets.numRulesParsed;
+  stats.numOptionalsFactored = offsets.numOptionalsFactored;
+  stats.numGroupsFactored = offsets.numGroupsFactored;
+  stats.numChoiceGroups = offsets.numChoiceGroups;
+  stats.numRulesOverBudget = offsets.numRulesOverBudget;
+  stats.numExpandTasks = offsets.numExpandTasks;
+  stats.numExpandTasksStolen = offsets.numExpandTasksStolen;
+  stats.expandTaskTime = offsets.expandTaskTime;
+  stats.maxExpandTaskTime = offsets.maxExpandTaskTime;
+}
+
+vector<Shard> splitAtRules(string_view input, size_t numShards) {
+  vector<Shard> shards;
+  size_t shardStart = 0;
+  unsigned shardLine = 1;
+  auto target = max<size_t>(input.size() / max<size_t>(numShards, 1), 1);
+  auto seenRule = false;
+  unsigned line = 1;
+  for(size_t i = 0; i < input.size(); ++line) {
+    if(isRuleStart(input, i)) {
+// first rule stays with the header
+      if(seenRule && i - shardStart >= target && shards.size() + 1 < numShards) {
+        shards.push_back({.text = input.substr(shardStart, i - shardStart), .firstLine = shardLine});
+        shardStart = i;
+        shardLine = line;
+      }
+      seenRule = true;
+    }
+    auto lineEnd = input.find('\n', i);
+    if(lineEnd == string_view::npos) {
+      break;
+    }
+    i = lineEnd + 1;
+  }
+  shards.push_back({.text = input.substr(shardStart), .firstLine = shardLine});
+  return shards;
+}
+
+int convertSharded(string_view input, const string* filename, BisonParam& bisonParam, size_t numThreads, bool useSimdLexer) {
+  auto startTime = steady_clock::now();
+
+// more shards than threads so a thread that finishes early takes another one
+  auto shards = splitAtRules(input, 4 * max<size_t>(numThreads, 1));
+  vector<unique_ptr<BisonParam>> shardParams(shards.size());
+  vector<int> results(shards.size());
+  atomic<size_t> nextShard{0};
+
+  auto work = [&] {
+    for(size_t k; (k = nextShard++) < shards.size();) {
+      shardParams[k] = make_unique<BisonParam>();
+      results[k] = parseShard(shards[k], filename, bisonParam.options, useSimdLexer, *shardParams[k]);
+    }
+  };
+
+  vector<thread> threads;
+  for(size_t i = 1; i < min(numThreads, shards.size()); ++i) {
+    threads.emplace_back(work);
+  }
+  work();
+  for(auto& t: threads) {
+    t.join();
+  }
+
+  auto& stats = bisonParam.stats;
+  stats = {};
+  stats.parseStartTime = startTime;
+  bisonParam.diagnostics.clear();
+  auto ev = 0;
+  for(size_t k = 0; k < shards.size(); ++k) {
+    if(results[k] != 0) {
+      ev = results[k];
+      ranges::copy(shardParams[k]->diagnostics, back_inserter(bisonParam.diagnostics));
+    }
+  }
+  if(ev != 0) {
+    bisonParam.result.clear();
+    return ev;
+  }
+
+// counters of each shard are offset by the totals of all shards before it
+  BisonParam::Stats offsets;
+  for(const auto& shardParam: shardParams) {
+    mergeShard(bisonParam, *shardParam, offsets);
+  }
+  setMergedCounts(bisonParam.stats, offsets);
+
+  stats.parseEndTime = steady_clock::now();
+  stats.parseTimeTakenSec = stats.parseEndTime - stats.parseStartTime;
+  return 0;
+}
+
+}
@@ -0,0 +1,71 @@
+#ifndef EBNFTOBISON_SHARDED_H
+#define EBNFTOBISON_SHARDED_H
+// ebnftobison_sharded.h
+
+/*
+MIT License
+
+Copyright (c) 2024 Zartaj Majeed
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "ebnftobison.bison.h"
+
+namespace ebnftobison {
+using namespace std;
+
+// piece of a grammar that starts with a rule at the beginning of a line, except the first that also has any header
+struct Shard {
+  string_view text;
+// line of input text starts on
+  unsigned firstLine = 1;
+};
+
+// same as the rule start pattern of the lexer, <name> and ::= with only spaces between them
+bool isRuleStart(string_view input, size_t i);
+
+// splits input at rule starts into at most numShards pieces of about equal size
+vector<Shard> splitAtRules(string_view input, size_t numShards);
+
+// parses one shard into a fresh shardParam with the given options, recording the helper names mergeShard needs
+// returns 0 on success like the parser
+int parseShard(const Shard& shard, const string* filename, const BisonParam::Options& options, bool useSimdLexer, BisonParam& shardParam);
+
+// adds the rules of a parsed shard to merged, helper names are renumbered after the counters in offsets
+// offsets are then advanced by the shard's counters so they are ready for the next shard
+void mergeShard(BisonParam& merged, const BisonParam& shard, BisonParam::Stats& offsets);
+
+// copies the counters summed in offsets to the stats of the merged conversion
+void setMergedCounts(BisonParam::Stats& stats, const BisonParam::Stats& offsets);
+
+// parses shards of input on numThreads threads, each shard with its own lexer and BisonParam, and merges them into bisonParam in input order
+// merged rules and helper names are the same as parsing input in one piece, counters like choice_group_N continue from earlier shards
+// bisonParam gives the options for every shard, keepTrees and ruleSink aren't supported
+// returns 0 on success like the parser, diagnostics of failed shards are added to bisonParam in input order
+int convertSharded(string_view input, const string* filename, BisonParam& bisonParam, size_t numThreads, bool useSimdLexer = false);
+
+}
+
+#endif